@@ -0,0 +1,116 @@
+// bench_concurrency.cpp
+// --------------------------------
+// Several processes sharing one vault file: commit and load throughput, and a
+// check that no commit is lost (POSIX only, uses fork).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+// usage: bench_concurrency [writers=4] [readers=8] [seconds=5] [vault=<tmp>/pv_bench_concurrency.vault]
+
+#include "vault.h"
+#include "merge.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    // initial file only: commits go through sync_vault and re-seal with the
+    // default 200k iterations like the app, so after the first one every
+    // commit and load includes a full KDF run (single digits per second per core)
+    constexpr uint32_t ITERATIONS = 1000;
+    constexpr int INITIAL_ENTRIES = 2000;
+    const std::string MASTER = "bench";
+
+    struct Tally {
+        long commits = 0, loads = 0, conflicts = 0, failures = 0;
+    };
+
+    // Writers behave like the app: load once, then add + sync_vault against
+    // the kept snapshot. Readers reload the file as fast as they can.
+    Tally run(const std::string& path, bool writer, int id, double seconds) {
+        Tally t;
+        auto end = std::chrono::steady_clock::now() + std::chrono::duration<double>(seconds);
+        Vault v, base;
+        if (writer) {
+            if (!load_vault(v, path, MASTER)) { t.failures++; return t; }
+            vault_copy(v, base);
+        }
+        while (std::chrono::steady_clock::now() < end) {
+            if (!writer) {
+                Vault r;
+                if (load_vault(r, path, MASTER)) t.loads++;
+                else t.failures++;
+                continue;
+            }
+            vault_add(v, "w" + std::to_string(id) + "-" + std::to_string(t.commits) + ".example.com", "user", "pw");
+            MergeResult mr;
+            if (sync_vault(v, base, path, MASTER, &mr, 100)) t.commits++;
+            else t.failures++;
+            t.conflicts += (long)mr.conflicts.size();
+        }
+        return t;
+    }
+}
+
+int main(int argc, char** argv) {
+    int writers = argc > 1 ? std::atoi(argv[1]) : 4;
+    int readers = argc > 2 ? std::atoi(argv[2]) : 8;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 5.0;
+    std::string path = argc > 4 ? argv[4] : (std::filesystem::temp_directory_path() / "pv_bench_concurrency.vault").string();
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    {
+        Vault v;
+        for (int i = 0; i < INITIAL_ENTRIES; i++) vault_add(v, "site" + std::to_string(i) + ".example.com", "user", "pw");
+        if (!save_vault(v, path, MASTER, ITERATIONS)) { std::fprintf(stderr, "cannot create %s\n", path.c_str()); return 1; }
+    }
+
+    // every child writes its tally into one pipe, results are read after all exit
+    int fds[2];
+    if (pipe(fds) != 0) return 1;
+    for (int k = 0; k < writers + readers; k++) {
+        if (fork() != 0) continue;
+        close(fds[0]);
+        Tally t = run(path, k < writers, k, seconds);
+        char line[128];
+        int n = std::snprintf(line, sizeof(line), "%d %ld %ld %ld %ld\n", k < writers, t.commits, t.loads, t.conflicts, t.failures);
+        ssize_t written = write(fds[1], line, (size_t)n);
+        _exit(written == n ? 0 : 1);
+    }
+    close(fds[1]);
+    for (int k = 0; k < writers + readers; k++) wait(nullptr);
+
+    Tally total;
+    FILE* in = fdopen(fds[0], "r");
+    int w;
+    Tally t;
+    while (in && std::fscanf(in, "%d %ld %ld %ld %ld", &w, &t.commits, &t.loads, &t.conflicts, &t.failures) == 5) {
+        total.commits += t.commits;
+        total.loads += t.loads;
+        total.conflicts += t.conflicts;
+        total.failures += t.failures;
+    }
+    if (in) std::fclose(in);
+
+    Vault final_vault;
+    if (!load_vault(final_vault, path, MASTER)) { std::fprintf(stderr, "final load failed\n"); return 1; }
+    long expected = INITIAL_ENTRIES + total.commits;
+
+    std::printf("writers %d, readers %d, %.1f s\n", writers, readers, seconds);
+    std::printf("commits   %8ld  (%.0f/s)\n", total.commits, total.commits / seconds);
+    std::printf("loads     %8ld  (%.0f/s)\n", total.loads, total.loads / seconds);
+    std::printf("conflicts %8ld  (entries edited on both sides, expected 0)\n", total.conflicts);
+    std::printf("failures  %8ld\n", total.failures);
+    std::printf("entries   %8zu  (expected %ld), generation %llu\n",
+        final_vault.entries.size(), expected, (unsigned long long)final_vault.generation);
+
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(path + ".lock", ec);
+    bool ok = total.failures == 0 && total.conflicts == 0 && (long)final_vault.entries.size() == expected;
+    if (!ok) std::fprintf(stderr, "FAILED: lost commits or failed operations\n");
+    return ok ? 0 : 1;
+}
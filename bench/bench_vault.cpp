@@ -0,0 +1,45 @@
+// bench_vault.cpp
+// --------------------------------
+// Save and unlock timings for a generated vault, written out as perf JSON.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+// usage: bench_vault [entries=10000] [rounds=5] [perf.json (default: stdout)]
+
+#include "vault.h"
+#include "perf.h"
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+int main(int argc, char** argv) {
+    size_t entries = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000;
+    int rounds = argc > 2 ? std::atoi(argv[2]) : 5;
+    std::string out = argc > 3 ? argv[3] : "";
+    std::string path = (std::filesystem::temp_directory_path() / "pv_bench_vault.vault").string();
+    const std::string master = "bench";
+
+    // a few shared usernames and domains, like a real vault
+    Vault v;
+    for (size_t i = 0; i < entries; i++)
+        vault_add(v, "login.site" + std::to_string(i % 2000) + ".example.com", "user" + std::to_string(i % 7) + "@example.com",
+            "pw-" + std::to_string(i * 2654435761u));
+
+    perf_set_enabled(true);
+    for (int r = 0; r < rounds; r++) {
+        if (!save_vault(v, path, master)) { std::fprintf(stderr, "save failed\n"); return 1; }
+        Vault loaded;
+        if (!load_vault(loaded, path, master) || loaded.entries.size() != v.entries.size()) {
+            std::fprintf(stderr, "load failed\n");
+            return 1;
+        }
+    }
+    perf_set_enabled(false);
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+    std::filesystem::remove(path + ".lock", ec);
+    if (out.empty()) std::printf("%s\n", perf_to_json().c_str());
+    else if (!perf_dump(out)) { std::fprintf(stderr, "cannot write %s\n", out.c_str()); return 1; }
+    return 0;
+}
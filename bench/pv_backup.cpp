@@ -0,0 +1,98 @@
+// pv_backup.cpp
+// --------------------------------
+// Command line front end for the incremental backups in backup.h.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+// usage:
+//   pv_backup backup  <vault.dat> <repo dir>
+//   pv_backup list    <repo dir>
+//   pv_backup restore <repo dir> <generation> <new vault file>
+// The master password is read from the first line of stdin (the vault and the
+// repository use the same one), so it can be piped in from a scheduled job.
+
+#include "backup.h"
+#include <openssl/crypto.h>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+namespace {
+    int usage() {
+        std::fprintf(stderr,
+            "usage: pv_backup backup <vault> <repo>\n"
+            "       pv_backup list <repo>\n"
+            "       pv_backup restore <repo> <generation> <new vault>\n");
+        return 2;
+    }
+
+    std::string read_master() {
+        std::fprintf(stderr, "master password: ");
+        std::string master;
+        std::getline(std::cin, master);
+        if (!master.empty() && master.back() == '\r') master.pop_back();
+        return master;
+    }
+
+    std::string format_time(std::time_t t) {
+        char buf[32];
+        std::tm tm{};
+#ifdef _WIN32
+        localtime_s(&tm, &t);
+#else
+        localtime_r(&t, &tm);
+#endif
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M", &tm);
+        return buf;
+    }
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) return usage();
+    std::string cmd = argv[1];
+    if ((cmd == "backup" && argc != 4) || (cmd == "list" && argc != 3) || (cmd == "restore" && argc != 5)) return usage();
+    if (cmd != "backup" && cmd != "list" && cmd != "restore") return usage();
+    if (cmd == "restore" && std::filesystem::exists(argv[4])) {
+        std::fprintf(stderr, "%s already exists, restore into a new file\n", argv[4]);
+        return 1;
+    }
+
+    std::string master = read_master();
+    auto done = [&](int rc) {
+        if (!master.empty()) OPENSSL_cleanse(&master[0], master.size());
+        return rc;
+    };
+
+    BackupRepo repo;
+    if (!repo.open(cmd == "backup" ? argv[3] : argv[2], master)) {
+        std::fprintf(stderr, "cannot open the backup repository (wrong password?)\n");
+        return done(1);
+    }
+
+    if (cmd == "backup") {
+        Vault v;
+        if (!load_vault(v, argv[2], master)) { std::fprintf(stderr, "cannot unlock %s\n", argv[2]); return done(1); }
+        BackupInfo bi;
+        if (!backup_vault(repo, v, &bi)) { std::fprintf(stderr, "backup failed\n"); return done(1); }
+        std::printf("generation %u: %zu entries, %zu chunks (%zu new), %llu bytes (%llu new)\n",
+            bi.generation, bi.entries, bi.chunks, bi.new_chunks,
+            (unsigned long long)bi.bytes, (unsigned long long)bi.new_bytes);
+        return done(0);
+    }
+
+    if (cmd == "list") {
+        std::vector<BackupInfo> all;
+        if (!list_backups(repo, all)) { std::fprintf(stderr, "cannot read the backups\n"); return done(1); }
+        for (auto& bi : all)
+            std::printf("%8u  %s  %zu entries\n", bi.generation, format_time(bi.created_at).c_str(), bi.entries);
+        return done(0);
+    }
+
+    Vault v;
+    uint32_t generation = (uint32_t)std::strtoul(argv[3], nullptr, 10);
+    if (!restore_backup(repo, generation, v)) { std::fprintf(stderr, "cannot restore generation %u\n", generation); return done(1); }
+    if (!save_vault(v, argv[4], master)) { std::fprintf(stderr, "cannot write %s\n", argv[4]); return done(1); }
+    std::printf("restored generation %u (%zu entries) to %s\n", generation, v.entries.size(), argv[4]);
+    return done(0);
+}
@@ -0,0 +1,167 @@
+// audit.cpp
+// --------------------------------
+// Password health audit across the whole vault.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "audit.h"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace {
+    constexpr size_t MIN_PER_THREAD = 2048; // below this a thread costs more than it saves
+
+    const char* const COMMON[] = {
+        "123456", "password", "12345678", "qwerty", "123456789", "12345", "1234", "111111",
+        "1234567", "dragon", "123123", "baseball", "abc123", "football", "monkey", "letmein",
+        "696969", "shadow", "master", "666666", "qwertyuiop", "123321", "mustang", "1234567890",
+        "michael", "654321", "superman", "1qaz2wsx", "7777777", "121212", "000000", "qazwsx",
+        "123qwe", "killer", "trustno1", "jordan", "jennifer", "zxcvbnm", "asdfgh", "hunter",
+        "buster", "soccer", "harley", "batman", "andrew", "tigger", "sunshine", "iloveyou",
+        "welcome", "admin", "login", "passw0rd", "password1", "starwars", "princess", "azerty"
+    };
+
+    const char* const KEYBOARD_ROWS[] = { "1234567890", "qwertyuiop", "asdfghjkl", "zxcvbnm" };
+
+    bool keyboard_adjacent(char a, char b) {
+        a = (char)std::tolower((unsigned char)a);
+        b = (char)std::tolower((unsigned char)b);
+        for (auto row : KEYBOARD_ROWS) {
+            const char* pa = std::strchr(row, a);
+            const char* pb = std::strchr(row, b);
+            if (pa && pb && a && b && (pa - pb == 1 || pb - pa == 1)) return true;
+        }
+        return false;
+    }
+
+    int char_class(unsigned char c) {
+        if (std::islower(c)) return 0;
+        if (std::isupper(c)) return 1;
+        if (std::isdigit(c)) return 2;
+        if (c < 128) return 3;
+        return 4;
+    }
+
+    // Runs fn(begin, end) over [0, count) split across `threads` workers.
+    void parallel_for(unsigned threads, size_t count, const std::function<void(size_t, size_t)>& fn) {
+        if (threads <= 1) { fn(0, count); return; }
+        std::vector<std::thread> pool;
+        size_t chunk = (count + threads - 1) / threads;
+        for (size_t b = 0; b < count; b += chunk)
+            pool.emplace_back(fn, b, std::min(count, b + chunk));
+        for (auto& t : pool) t.join();
+    }
+}
+
+double estimate_entropy(std::string_view password) {
+    if (password.empty()) return 0.0;
+
+    std::string lower(password);
+    std::transform(lower.begin(), lower.end(), lower.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    for (auto c : COMMON)
+        if (lower == c) return std::log2((double)(sizeof(COMMON) / sizeof(COMMON[0])));
+
+    bool seen[5] = {};
+    for (unsigned char c : password) seen[char_class(c)] = true;
+    static const int POOL[5] = { 26, 26, 10, 33, 100 };
+    int pool = 0;
+    for (int i = 0; i < 5; i++) if (seen[i]) pool += POOL[i];
+    double full = std::log2((double)pool);
+
+    double bits = full;
+    for (size_t i = 1; i < password.size(); i++) {
+        unsigned char prev = password[i - 1], c = password[i];
+        if (c == prev) bits += 1.0;
+        else if (char_class(c) == char_class(prev) && (c - prev == 1 || prev - c == 1)) bits += 1.5;
+        else if (keyboard_adjacent((char)prev, (char)c)) bits += 2.0;
+        else bits += full;
+    }
+    return bits;
+}
+
+Strength strength_from_entropy(double bits) {
+    if (bits < 40.0) return Strength::Weak;
+    if (bits < 60.0) return Strength::Medium;
+    if (bits < 80.0) return Strength::Strong;
+    return Strength::VeryStrong;
+}
+
+const char* strength_label(Strength s) {
+    switch (s) {
+    case Strength::Weak: return "Weak";
+    case Strength::Medium: return "Medium";
+    case Strength::Strong: return "Strong";
+    default: return "Very Strong";
+    }
+}
+
+AuditReport audit_vault(const Vault& v, const AuditOptions& opt) {
+    AuditReport r;
+    const size_t n = v.entries.size();
+    r.items.resize(n);
+    if (n == 0) return r;
+
+    unsigned threads = opt.threads ? opt.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, n / MIN_PER_THREAD));
+    const std::time_t now = opt.now ? opt.now : std::time(nullptr);
+
+    // 1) score each entry and count uses of each password. Passwords are
+    //    interned, so equal passwords share a pool id and a counter.
+    std::unique_ptr<std::atomic<uint32_t>[]> uses(new std::atomic<uint32_t>[v.strings.count()]());
+    parallel_for(threads, n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            const EntryView en = vault_entry(v, i);
+            AuditItem& it = r.items[i];
+            it.index = i;
+            it.entropy = estimate_entropy(en.password);
+            it.strength = strength_from_entropy(it.entropy);
+            it.weak = it.entropy < opt.weak_below_bits;
+            // age counts from the last edit, so a rotated password is fresh again
+            const std::time_t changed = std::max(en.saved_at, en.modified_at);
+            it.age_days = changed > 0 && now > changed ? (int)((now - changed) / 86400) : 0;
+            it.stale = changed > 0 && it.age_days >= opt.stale_after_days;
+            it.breached = opt.breach && !en.password.empty() && opt.breach->contains(en.password);
+
+            if (!en.password.empty())
+                uses[v.entries[i].password].fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // 2) counts are final after the join
+    parallel_for(threads, n, [&](size_t b, size_t e) {
+        for (size_t i = b; i < e; i++) {
+            if (v.strings.get(v.entries[i].password).empty()) continue;
+            size_t count = uses[v.entries[i].password].load(std::memory_order_relaxed);
+            r.items[i].reuse_count = count;
+            r.items[i].reused = count > 1;
+        }
+    });
+
+    for (auto& it : r.items) {
+        r.weak += it.weak;
+        r.reused += it.reused;
+        r.stale += it.stale;
+        r.breached += it.breached;
+    }
+    return r;
+}
+
+void sort_audit(AuditReport& r, AuditSort by, bool descending) {
+    auto key = [by](const AuditItem& a) -> double {
+        switch (by) {
+        case AuditSort::Entropy: return a.entropy;
+        case AuditSort::Reuse: return (double)a.reuse_count;
+        case AuditSort::Age: return (double)a.age_days;
+        default: return (double)a.index;
+        }
+    };
+    std::stable_sort(r.items.begin(), r.items.end(), [&](const AuditItem& a, const AuditItem& b) {
+        return descending ? key(a) > key(b) : key(a) < key(b);
+    });
+}
@@ -0,0 +1,55 @@
+// audit.h
+// --------------------------------
+// Vault-wide password health audit (weak, reused, old).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ctime>
+#include <cstddef>
+#include "vault.h"
+#include "breach.h"
+
+enum class Strength { Weak, Medium, Strong, VeryStrong };
+
+// Estimated guessing entropy in bits. Charset size per character, with
+// repeats, sequences (abc, 321), keyboard runs (qwerty) and common
+// passwords scored as the cheap guesses they are.
+double estimate_entropy(std::string_view password);
+Strength strength_from_entropy(double bits);
+const char* strength_label(Strength s);
+
+struct AuditOptions {
+    double weak_below_bits = 40.0;
+    int stale_after_days = 365;
+    unsigned threads = 0; // 0 = all cores
+    std::time_t now = 0;  // 0 = std::time(nullptr)
+    const BreachCorpus* breach = nullptr; // optional offline breach check
+};
+
+struct AuditItem {
+    size_t index = 0;          // into Vault::entries
+    double entropy = 0.0;
+    Strength strength = Strength::Weak;
+    size_t reuse_count = 1;    // entries sharing this password (1 = unique)
+    int age_days = 0;          // since the entry was last saved or edited
+    bool weak = false;
+    bool reused = false;
+    bool stale = false;
+    bool breached = false;
+};
+
+struct AuditReport {
+    std::vector<AuditItem> items; // one per entry, in vault order until sorted
+    size_t weak = 0;
+    size_t reused = 0;
+    size_t stale = 0;
+    size_t breached = 0;
+};
+
+enum class AuditSort { Index, Entropy, Reuse, Age };
+
+AuditReport audit_vault(const Vault& v, const AuditOptions& opt = {});
+void sort_audit(AuditReport& r, AuditSort by, bool descending = false);
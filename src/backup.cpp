@@ -0,0 +1,245 @@
+// backup.cpp
+// --------------------------------
+// Incremental, deduplicated, encrypted vault backups.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "backup.h"
+#include "crypto.h"
+#include "compress.h"
+#include "file_util.h"
+#include <nlohmann/json.hpp>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+    const uint8_t CONFIG_MAGIC[4] = { 'P','M','B','1' };
+    constexpr size_t TAG_LEN = 16;
+    constexpr size_t IV_LEN = 12;
+
+    // FastCDC-style chunking: ~8 KiB average, harder to cut before the
+    // average and easier after it, so sizes cluster around it.
+    constexpr size_t MIN_CHUNK = 2 * 1024;
+    constexpr size_t AVG_CHUNK = 8 * 1024;
+    constexpr size_t MAX_CHUNK = 64 * 1024;
+    constexpr uint64_t MASK_S = 0xFFFE000000000000ull; // 15 bits
+    constexpr uint64_t MASK_L = 0xFFE0000000000000ull; // 11 bits
+
+    struct GearTable {
+        uint64_t t[256];
+        GearTable() {
+            // fixed seed: chunk boundaries must be the same on every machine
+            uint64_t x = 0x9E3779B97F4A7C15ull;
+            for (auto& v : t) {
+                uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+                v = z ^ (z >> 31);
+            }
+        }
+    };
+    const GearTable GEAR;
+
+    size_t cut_point(const uint8_t* p, size_t n) {
+        if (n <= MIN_CHUNK) return n;
+        const size_t limit = std::min(n, MAX_CHUNK);
+        const size_t normal = std::min(limit, AVG_CHUNK);
+        uint64_t h = 0;
+        size_t i = MIN_CHUNK;
+        for (; i < normal; i++) {
+            h = (h << 1) + GEAR.t[p[i]];
+            if (!(h & MASK_S)) return i + 1;
+        }
+        for (; i < limit; i++) {
+            h = (h << 1) + GEAR.t[p[i]];
+            if (!(h & MASK_L)) return i + 1;
+        }
+        return limit;
+    }
+
+    fs::path chunk_path(const std::string& dir, const std::string& id) {
+        return fs::path(dir) / "chunks" / id.substr(0, 2) / id;
+    }
+
+    fs::path manifest_path(const std::string& dir, uint32_t generation) {
+        char name[16];
+        std::snprintf(name, sizeof(name), "%08u", generation);
+        return fs::path(dir) / "manifests" / name;
+    }
+
+    std::vector<uint8_t> generation_aad(uint32_t generation) {
+        std::vector<uint8_t> aad = { 'P','M','B','M', 0, 0, 0, 0 };
+        std::memcpy(aad.data() + 4, &generation, 4);
+        return aad;
+    }
+
+    // The IV comes from the (keyed) chunk id, so the same chunk always
+    // encrypts to the same file. Only identical plaintexts ever share an IV.
+    bool seal_chunk(const BackupRepo& repo, const std::vector<uint8_t>& id, const std::vector<uint8_t>& plain, std::vector<uint8_t>& out) {
+        std::vector<uint8_t> packed, tag;
+        if (!deflate_payload(plain, packed)) return false;
+        std::vector<uint8_t> iv(id.begin(), id.begin() + IV_LEN);
+        if (!aes256gcm_encrypt(repo.chunk_key, iv, packed, id, out, tag)) return false;
+        out.insert(out.end(), tag.begin(), tag.end());
+        return true;
+    }
+
+    bool open_chunk(const BackupRepo& repo, const std::vector<uint8_t>& id, const std::vector<uint8_t>& sealed, std::vector<uint8_t>& plain) {
+        if (sealed.size() < TAG_LEN) return false;
+        std::vector<uint8_t> iv(id.begin(), id.begin() + IV_LEN);
+        std::vector<uint8_t> ct(sealed.begin(), sealed.end() - TAG_LEN), tag(sealed.end() - TAG_LEN, sealed.end());
+        std::vector<uint8_t> packed, check;
+        if (!aes256gcm_decrypt(repo.chunk_key, iv, ct, id, tag, packed)) return false;
+        if (!inflate_payload(packed, plain)) return false;
+        return hmac_sha256(repo.id_key, plain.data(), plain.size(), check) && check == id;
+    }
+
+    bool read_manifest(const BackupRepo& repo, uint32_t generation, json& out) {
+        std::vector<uint8_t> file, plain;
+        if (!read_file(manifest_path(repo.dir, generation).string(), file) || file.size() < IV_LEN + TAG_LEN) return false;
+        std::vector<uint8_t> iv(file.begin(), file.begin() + IV_LEN);
+        std::vector<uint8_t> ct(file.begin() + IV_LEN, file.end() - TAG_LEN), tag(file.end() - TAG_LEN, file.end());
+        if (!aes256gcm_decrypt(repo.manifest_key, iv, ct, generation_aad(generation), tag, plain)) return false;
+        out = json::parse(plain.begin(), plain.end(), nullptr, false);
+        return !out.is_discarded();
+    }
+
+    std::vector<uint32_t> generations(const std::string& dir) {
+        std::vector<uint32_t> out;
+        std::error_code ec;
+        for (auto& it : fs::directory_iterator(fs::path(dir) / "manifests", ec)) {
+            std::string name = it.path().filename().string();
+            if (name.size() == 8 && std::all_of(name.begin(), name.end(), ::isdigit))
+                out.push_back((uint32_t)std::stoul(name));
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+}
+
+bool BackupRepo::open(const std::string& path, const std::string& master, uint32_t iterations) {
+    close();
+    dir = path;
+    bool ok = open_key_config((fs::path(dir) / "config").string(), CONFIG_MAGIC, master, iterations, "pmv backup check",
+        { { "pmv backup chunk id", &id_key }, { "pmv backup chunk key", &chunk_key }, { "pmv backup manifest key", &manifest_key } },
+        [&]() {
+            std::error_code ec;
+            fs::create_directories(fs::path(dir) / "chunks", ec);
+            if (!ec) fs::create_directories(fs::path(dir) / "manifests", ec);
+            return !ec;
+        });
+    if (!ok) close();
+    return ok;
+}
+
+void BackupRepo::close() {
+    for (auto* k : { &id_key, &chunk_key, &manifest_key }) {
+        if (!k->empty()) OPENSSL_cleanse(k->data(), k->size());
+        k->clear();
+    }
+}
+
+bool backup_vault(const BackupRepo& repo, const Vault& v, BackupInfo* info) {
+    if (repo.id_key.empty()) return false;
+    BackupInfo bi;
+    auto gens = generations(repo.dir);
+    bi.generation = gens.empty() ? 1 : gens.back() + 1;
+    bi.created_at = std::time(nullptr);
+    bi.entries = v.entries.size();
+
+    // 1) Chunk the payload, write only chunks we don't have yet
+    std::string payload = vault_serialize(v);
+    const uint8_t* p = (const uint8_t*)payload.data();
+    bi.bytes = payload.size();
+    json ids = json::array();
+    std::vector<uint8_t> id, sealed;
+    bool ok = true;
+    for (size_t off = 0; ok && off < payload.size();) {
+        size_t len = cut_point(p + off, payload.size() - off);
+        std::vector<uint8_t> chunk(p + off, p + off + len);
+        off += len;
+
+        if (!hmac_sha256(repo.id_key, chunk.data(), chunk.size(), id)) { ok = false; break; }
+        std::string hex = to_hex(id);
+        ids.push_back(hex);
+        bi.chunks++;
+
+        fs::path path = chunk_path(repo.dir, hex);
+        std::error_code ec;
+        if (!fs::exists(path, ec)) {
+            fs::create_directories(path.parent_path(), ec);
+            ok = seal_chunk(repo, id, chunk, sealed) && write_file_atomic(path.string(), sealed);
+            bi.new_chunks++;
+            bi.new_bytes += len;
+        }
+        OPENSSL_cleanse(chunk.data(), chunk.size());
+    }
+    OPENSSL_cleanse(&payload[0], payload.size());
+    if (!ok) return false;
+
+    // 2) Manifest last, so a generation only exists once all its chunks do
+    std::string m = json{
+        {"generation", bi.generation},
+        {"created_at", bi.created_at},
+        {"entries", bi.entries},
+        {"bytes", bi.bytes},
+        {"chunks", ids}
+    }.dump();
+    std::vector<uint8_t> plain(m.begin(), m.end()), iv(IV_LEN), ct, tag;
+    RAND_bytes(iv.data(), (int)iv.size());
+    if (!aes256gcm_encrypt(repo.manifest_key, iv, plain, generation_aad(bi.generation), ct, tag)) return false;
+    std::vector<uint8_t> file = iv;
+    file.insert(file.end(), ct.begin(), ct.end());
+    file.insert(file.end(), tag.begin(), tag.end());
+    if (!write_file_atomic(manifest_path(repo.dir, bi.generation).string(), file)) return false;
+
+    if (info) *info = bi;
+    return true;
+}
+
+bool list_backups(const BackupRepo& repo, std::vector<BackupInfo>& out) {
+    if (repo.id_key.empty()) return false;
+    out.clear();
+    for (uint32_t g : generations(repo.dir)) {
+        json m;
+        if (!read_manifest(repo, g, m)) continue; // skip damaged manifests, keep listing
+        BackupInfo bi;
+        bi.generation = g;
+        bi.created_at = m.value("created_at", std::time_t(0));
+        bi.entries = m.value("entries", size_t(0));
+        bi.bytes = m.value("bytes", uint64_t(0));
+        bi.chunks = m.value("chunks", json::array()).size();
+        out.push_back(bi);
+    }
+    return true;
+}
+
+bool restore_backup(const BackupRepo& repo, uint32_t generation, Vault& v) {
+    if (repo.id_key.empty()) return false;
+    json m;
+    if (!read_manifest(repo, generation, m)) return false;
+
+    std::string payload;
+    payload.reserve(m.value("bytes", size_t(0)));
+    std::vector<uint8_t> id, sealed, plain;
+    for (auto& hex : m.value("chunks", json::array())) {
+        if (!hex.is_string() || !from_hex(hex.get<std::string>(), id) || id.size() != 32) return false;
+        if (!read_file(chunk_path(repo.dir, hex.get<std::string>()).string(), sealed)) return false;
+        if (!open_chunk(repo, id, sealed, plain)) return false;
+        payload.append(plain.begin(), plain.end());
+        OPENSSL_cleanse(plain.data(), plain.size());
+    }
+
+    bool ok = vault_deserialize(v, payload);
+    if (!payload.empty()) OPENSSL_cleanse(&payload[0], payload.size());
+    if (ok) v.dirty = true; // restored content isn't in vault.dat yet
+    return ok;
+}
@@ -0,0 +1,49 @@
+// backup.h
+// --------------------------------
+// Incremental, deduplicated, encrypted vault backups.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstdint>
+#include "vault.h"
+
+// Backup directory layout:
+//   config                 salt + iterations + key check, written once
+//   chunks/ab/abcdef...    one encrypted chunk each, named by its keyed id
+//   manifests/00000001     encrypted list of chunk ids for one generation
+//
+// The plaintext payload is cut with content-defined chunking, so an edit
+// only changes the chunks around it. Chunk ids are HMACs of the content under
+// a key derived from the master password, so identical content maps to the
+// same stored file and each backup only writes chunks that are new.
+//
+// The app doesn't call these; bench/pv_backup.cpp is the command line front
+// end (backup, list, restore).
+struct BackupRepo {
+    std::string dir;
+    std::vector<uint8_t> id_key;       // chunk ids
+    std::vector<uint8_t> chunk_key;    // chunk encryption
+    std::vector<uint8_t> manifest_key; // manifest encryption
+
+    // Creates the repository on first use. Fails on a wrong master password.
+    bool open(const std::string& dir, const std::string& master, uint32_t iterations = 200000);
+    void close(); // wipes the keys
+    ~BackupRepo() { close(); }
+};
+
+struct BackupInfo {
+    uint32_t generation = 0;
+    std::time_t created_at = 0;
+    size_t entries = 0;
+    size_t chunks = 0;
+    size_t new_chunks = 0;     // only filled in by backup_vault
+    uint64_t bytes = 0;        // plaintext payload size
+    uint64_t new_bytes = 0;    // plaintext bytes that had to be written
+};
+
+bool backup_vault(const BackupRepo& repo, const Vault& v, BackupInfo* info = nullptr);
+bool list_backups(const BackupRepo& repo, std::vector<BackupInfo>& out);
+bool restore_backup(const BackupRepo& repo, uint32_t generation, Vault& v);
@@ -0,0 +1,322 @@
+// breach.cpp
+// --------------------------------
+// Memory-mapped search over a sorted breached-hash dump + Bloom sidecar.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "breach.h"
+#include <openssl/evp.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // v2 ties the filter to the corpus it was built from (size + fingerprint);
+    // v1 sidecars ('PMBF') had no such check and are ignored
+    const uint8_t FILTER_MAGIC[4] = { 'P','M','B','2' };
+    constexpr size_t FILTER_HEADER = 40; // magic, kind, k, reserved, bit count, corpus size, corpus fingerprint
+    constexpr size_t FINGERPRINT_SPAN = 64 * 1024;
+    constexpr int INTERPOLATION_PROBES = 4; // hashes are uniform, after that plain bisection
+
+    size_t digest_len(HashKind kind) {
+        return kind == HashKind::NTLM ? 16 : 20;
+    }
+
+    // NTLM hashes the UTF-16LE form of the password
+    std::vector<uint8_t> utf16le(std::string_view s) {
+        std::vector<uint8_t> out;
+        out.reserve(s.size() * 2);
+        for (size_t i = 0; i < s.size();) {
+            unsigned char c = s[i];
+            uint32_t cp = c;
+            size_t n = 1;
+            if (c >= 0xF0) { cp = c & 0x07; n = 4; }
+            else if (c >= 0xE0) { cp = c & 0x0F; n = 3; }
+            else if (c >= 0xC0) { cp = c & 0x1F; n = 2; }
+            if (i + n > s.size()) { cp = 0xFFFD; n = 1; }
+            else for (size_t k = 1; k < n; k++) cp = (cp << 6) | (s[i + k] & 0x3F);
+            i += n;
+
+            auto put = [&](uint16_t u) { out.push_back((uint8_t)(u & 0xFF)); out.push_back((uint8_t)(u >> 8)); };
+            if (cp >= 0x10000) {
+                cp -= 0x10000;
+                put((uint16_t)(0xD800 | (cp >> 10)));
+                put((uint16_t)(0xDC00 | (cp & 0x3FF)));
+            }
+            else {
+                put((uint16_t)cp);
+            }
+        }
+        return out;
+    }
+
+    bool hash_password(HashKind kind, std::string_view password, uint8_t* out) {
+        unsigned int len = 0;
+        if (kind == HashKind::NTLM) {
+            // MD4 lives in OpenSSL 3's legacy provider, this fails cleanly without it
+            auto wide = utf16le(password);
+            return EVP_Digest(wide.data(), wide.size(), out, &len, EVP_md4(), nullptr) == 1;
+        }
+        return EVP_Digest(password.data(), password.size(), out, &len, EVP_sha1(), nullptr) == 1;
+    }
+
+    int hex_value(uint8_t c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return -1;
+    }
+
+    bool parse_hex(const uint8_t* p, const uint8_t* end, uint8_t* out, size_t n) {
+        if ((size_t)(end - p) < n * 2) return false;
+        for (size_t i = 0; i < n; i++) {
+            int hi = hex_value(p[2 * i]), lo = hex_value(p[2 * i + 1]);
+            if (hi < 0 || lo < 0) return false;
+            out[i] = (uint8_t)(hi << 4 | lo);
+        }
+        return true;
+    }
+
+    uint64_t prefix64(const uint8_t* d) {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; i++) v = v << 8 | d[i];
+        return v;
+    }
+
+    uint64_t load_le64(const uint8_t* d) {
+        uint64_t v = 0;
+        for (int i = 7; i >= 0; i--) v = v << 8 | d[i];
+        return v;
+    }
+
+    // SHA-256 over the first and last 64 KiB, together with the size this
+    // changes whenever a newer dump replaces the old one
+    uint64_t corpus_fingerprint(const MappedFile& f) {
+        uint8_t md[32];
+        unsigned int len = 0;
+        EVP_MD_CTX* ctx = EVP_MD_CTX_new();
+        if (!ctx) return 0;
+        size_t head = std::min(f.size, FINGERPRINT_SPAN);
+        size_t tail = std::min(f.size - head, FINGERPRINT_SPAN);
+        bool ok = EVP_DigestInit_ex(ctx, EVP_sha256(), nullptr) == 1
+            && EVP_DigestUpdate(ctx, f.data, head) == 1
+            && EVP_DigestUpdate(ctx, f.data + f.size - tail, tail) == 1
+            && EVP_DigestFinal_ex(ctx, md, &len) == 1;
+        EVP_MD_CTX_free(ctx);
+        return ok ? load_le64(md) : 0;
+    }
+
+    // the digest is already uniformly random, so two words of it are the two bloom hashes
+    template <typename Fn>
+    void bloom_positions(const uint8_t* digest, uint32_t k, uint64_t bits, Fn fn) {
+        uint64_t h1 = load_le64(digest);
+        uint64_t h2 = load_le64(digest + 8) | 1;
+        for (uint32_t i = 0; i < k; i++)
+            fn((h1 + i * h2) % bits);
+    }
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER sz;
+    if (!GetFileSizeEx(f, &sz) || sz.QuadPart == 0) { CloseHandle(f); return false; }
+    HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m) { CloseHandle(f); return false; }
+    void* view = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+    if (!view) { CloseHandle(m); CloseHandle(f); return false; }
+    file = f;
+    mapping = m;
+    data = (const uint8_t*)view;
+    size = (size_t)sz.QuadPart;
+#else
+    int f = ::open(path.c_str(), O_RDONLY);
+    if (f < 0) return false;
+    struct stat st;
+    if (fstat(f, &st) != 0 || st.st_size == 0) { ::close(f); return false; }
+    void* view = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, f, 0);
+    if (view == MAP_FAILED) { ::close(f); return false; }
+    madvise(view, (size_t)st.st_size, MADV_RANDOM);
+    fd = f;
+    data = (const uint8_t*)view;
+    size = (size_t)st.st_size;
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+    if (!data) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    file = mapping = nullptr;
+#else
+    munmap((void*)data, size);
+    ::close(fd);
+    fd = -1;
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+bool BreachCorpus::open(const std::string& path, HashKind k) {
+    close();
+    kind = k;
+
+    // make sure this OpenSSL build can produce the digest at all
+    uint8_t probe[32];
+    if (!hash_password(kind, "", probe)) return false;
+    if (!corpus.open(path)) return false;
+
+    // the sidecar is optional, ignore it if it's for another corpus (kind, size
+    // or content) or damaged. A stale filter would turn new hashes into misses.
+    if (filter.open(path + ".bloom")) {
+        uint32_t fkind = 0;
+        uint64_t bits = 0, csize = 0, cprint = 0;
+        bool ok = filter.size > FILTER_HEADER && std::memcmp(filter.data, FILTER_MAGIC, 4) == 0;
+        if (ok) {
+            std::memcpy(&fkind, filter.data + 4, 4);
+            std::memcpy(&filter_k, filter.data + 8, 4);
+            std::memcpy(&bits, filter.data + 16, 8);
+            std::memcpy(&csize, filter.data + 24, 8);
+            std::memcpy(&cprint, filter.data + 32, 8);
+            ok = fkind == (uint32_t)kind && filter_k > 0 && bits > 0 && (bits + 7) / 8 <= filter.size - FILTER_HEADER
+                && csize == corpus.size && cprint == corpus_fingerprint(corpus);
+        }
+        if (ok) filter_bits = bits;
+        else filter.close();
+    }
+    return true;
+}
+
+void BreachCorpus::close() {
+    corpus.close();
+    filter.close();
+    filter_k = 0;
+    filter_bits = 0;
+}
+
+bool BreachCorpus::contains(std::string_view password, uint32_t* count) const {
+    if (!is_open()) return false;
+
+    uint8_t digest[32];
+    const size_t dlen = digest_len(kind);
+    if (!hash_password(kind, password, digest)) return false;
+
+    // 1) Bloom filter: a miss here is a definite miss
+    if (has_filter()) {
+        const uint8_t* bits = filter.data + FILTER_HEADER;
+        bool maybe = true;
+        bloom_positions(digest, filter_k, filter_bits, [&](uint64_t b) {
+            if (!(bits[b >> 3] & (1u << (b & 7)))) maybe = false;
+        });
+        if (!maybe) return false;
+    }
+
+    // 2) Search the dump. lo and hi are always line starts, the keys track the
+    //    lines just outside the range so the first probes can interpolate.
+    const uint8_t* base = corpus.data;
+    size_t lo = 0, hi = corpus.size;
+    uint64_t key = prefix64(digest), lo_key = 0, hi_key = UINT64_MAX;
+    int probes = 0;
+    auto line_end = [&](size_t from) {
+        const uint8_t* nl = (const uint8_t*)std::memchr(base + from, '\n', corpus.size - from);
+        return nl ? (size_t)(nl - base) + 1 : corpus.size;
+    };
+
+    while (lo < hi) {
+        size_t p = lo + (hi - lo) / 2;
+        if (probes++ < INTERPOLATION_PROBES && hi_key > lo_key && key >= lo_key && key <= hi_key) {
+            long double f = (long double)(key - lo_key) / (long double)(hi_key - lo_key);
+            p = lo + (size_t)(f * (long double)(hi - lo));
+            if (p >= hi) p = hi - 1;
+        }
+
+        size_t s = p;
+        while (s > lo && base[s - 1] != '\n') s--;
+        size_t e = line_end(s);
+
+        // blank or junk line: compare the next good line instead, the lines
+        // before it in [lo, s) stay in range
+        uint8_t cur[32];
+        size_t gs = s, ge = e;
+        while (gs < hi && !parse_hex(base + gs, base + ge, cur, dlen)) { gs = ge; ge = line_end(gs); }
+        if (gs >= hi) { hi = s; continue; } // only junk from s to hi
+
+        int c = std::memcmp(cur, digest, dlen);
+        if (c == 0) {
+            if (count) {
+                *count = 0;
+                for (size_t i = gs + dlen * 2 + 1; i < ge && base[i] >= '0' && base[i] <= '9'; i++)
+                    *count = *count * 10 + (base[i] - '0');
+            }
+            return true;
+        }
+        if (c < 0) { lo = ge; lo_key = prefix64(cur); }
+        else { hi = s; hi_key = prefix64(cur); }
+    }
+    return false;
+}
+
+bool build_breach_filter(const std::string& corpus_path, HashKind kind, uint32_t bits_per_entry) {
+    MappedFile corpus;
+    if (!corpus.open(corpus_path)) return false;
+    const size_t dlen = digest_len(kind);
+    const uint8_t* end = corpus.data + corpus.size;
+
+    // 1) count hashes to size the filter
+    uint64_t n = 0;
+    for (const uint8_t* p = corpus.data; p < end;) {
+        const uint8_t* nl = (const uint8_t*)std::memchr(p, '\n', (size_t)(end - p));
+        const uint8_t* e = nl ? nl + 1 : end;
+        if ((size_t)(e - p) >= dlen * 2) n++;
+        p = e;
+    }
+
+    uint64_t bits = std::max<uint64_t>(64, n * std::max<uint32_t>(1, bits_per_entry));
+    uint32_t k = (uint32_t)std::lround(std::max<uint32_t>(1, bits_per_entry) * 0.6931);
+    k = std::min<uint32_t>(16, std::max<uint32_t>(1, k));
+
+    // 2) set bits
+    std::vector<uint8_t> filter((size_t)((bits + 7) / 8), 0);
+    uint8_t digest[32];
+    for (const uint8_t* p = corpus.data; p < end;) {
+        const uint8_t* nl = (const uint8_t*)std::memchr(p, '\n', (size_t)(end - p));
+        const uint8_t* e = nl ? nl + 1 : end;
+        if (parse_hex(p, e, digest, dlen))
+            bloom_positions(digest, k, bits, [&](uint64_t b) { filter[b >> 3] |= (uint8_t)(1u << (b & 7)); });
+        p = e;
+    }
+
+    // 3) write sidecar
+    std::ofstream f(corpus_path + ".bloom", std::ios::binary | std::ios::trunc);
+    if (!f) return false;
+    uint32_t fkind = (uint32_t)kind, reserved = 0;
+    uint64_t csize = corpus.size, cprint = corpus_fingerprint(corpus);
+    f.write((const char*)FILTER_MAGIC, 4);
+    f.write((const char*)&fkind, 4);
+    f.write((const char*)&k, 4);
+    f.write((const char*)&reserved, 4);
+    f.write((const char*)&bits, 8);
+    f.write((const char*)&csize, 8);
+    f.write((const char*)&cprint, 8);
+    f.write((const char*)filter.data(), (std::streamsize)filter.size());
+    return (bool)f;
+}
@@ -0,0 +1,56 @@
+// breach.h
+// --------------------------------
+// Offline breached-password lookups against a local HIBP-style hash dump.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+// Which hash the corpus is sorted by ("pwned-passwords-sha1-ordered-by-hash"
+// or the NTLM variant). Lines look like "HEXDIGEST:COUNT", sorted by digest.
+enum class HashKind : uint32_t { SHA1 = 1, NTLM = 2 };
+
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+#ifdef _WIN32
+    void* file = nullptr;
+    void* mapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool open(const std::string& path);
+    void close();
+    ~MappedFile() { close(); }
+};
+
+struct BreachCorpus {
+    // Maps the corpus and, if present, its Bloom filter sidecar (path + ".bloom").
+    bool open(const std::string& path, HashKind kind = HashKind::SHA1);
+    void close();
+    bool is_open() const { return corpus.data != nullptr; }
+    bool has_filter() const { return filter.data != nullptr; }
+
+    // Safe to call from several threads at once. `count` gets the breach
+    // count from the dump when the password is found.
+    bool contains(std::string_view password, uint32_t* count = nullptr) const;
+
+    BreachCorpus() = default;
+    BreachCorpus(const BreachCorpus&) = delete;
+    BreachCorpus& operator=(const BreachCorpus&) = delete;
+
+    HashKind kind = HashKind::SHA1;
+    MappedFile corpus;
+    MappedFile filter;
+    uint32_t filter_k = 0;
+    uint64_t filter_bits = 0;
+};
+
+// One pass over the corpus to build the Bloom filter sidecar. ~1% false
+// positives at the default 10 bits per hash, so most misses never touch the dump.
+bool build_breach_filter(const std::string& corpus_path, HashKind kind = HashKind::SHA1, uint32_t bits_per_entry = 10);
@@ -0,0 +1,117 @@
+// compress.cpp
+// --------------------------------
+// zlib compression for the vault payload (applied before encryption).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "compress.h"
+#include "perf.h"
+#include <zlib.h>
+#include <algorithm>
+#include <climits>
+
+namespace {
+    constexpr size_t CHUNK = 64 * 1024;
+}
+
+bool deflate_payload(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, int level) {
+    PerfScope timer(PerfMetric::Compress);
+    if (in.size() > UINT_MAX) return false;
+    z_stream zs{};
+    if (deflateInit(&zs, level) != Z_OK) return false;
+
+    out.clear();
+    zs.next_in = const_cast<Bytef*>(in.data());
+    zs.avail_in = (uInt)in.size();
+
+    int ret;
+    do {
+        size_t have = out.size();
+        out.resize(have + CHUNK);
+        zs.next_out = out.data() + have;
+        zs.avail_out = (uInt)CHUNK;
+        ret = deflate(&zs, Z_FINISH);
+        out.resize(have + CHUNK - zs.avail_out);
+    } while (ret == Z_OK);
+
+    deflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+bool inflate_payload(const std::vector<uint8_t>& in, std::vector<uint8_t>& out) {
+    PerfScope timer(PerfMetric::Decompress);
+    if (in.size() > UINT_MAX) return false;
+    z_stream zs{};
+    if (inflateInit(&zs) != Z_OK) return false;
+
+    out.clear();
+    zs.next_in = const_cast<Bytef*>(in.data());
+    zs.avail_in = (uInt)in.size();
+
+    int ret;
+    do {
+        size_t have = out.size();
+        out.resize(have + CHUNK);
+        zs.next_out = out.data() + have;
+        zs.avail_out = (uInt)CHUNK;
+        ret = inflate(&zs, Z_NO_FLUSH);
+        out.resize(have + CHUNK - zs.avail_out);
+    } while (ret == Z_OK);
+
+    inflateEnd(&zs);
+    return ret == Z_STREAM_END;
+}
+
+Deflater::Deflater() : zs(new z_stream_s()) {}
+
+Deflater::~Deflater() {
+    if (active) deflateEnd(zs.get());
+}
+
+bool Deflater::begin(std::vector<uint8_t>& o, int level) {
+    if (active) deflateEnd(zs.get());
+    *zs = z_stream_s();
+    active = deflateInit(zs.get(), level) == Z_OK;
+    out = &o;
+    out->clear();
+    return active;
+}
+
+bool Deflater::pump(int flush) {
+    int ret;
+    do {
+        size_t have = out->size();
+        out->resize(have + CHUNK);
+        zs->next_out = out->data() + have;
+        zs->avail_out = (uInt)CHUNK;
+        ret = deflate(zs.get(), flush);
+        out->resize(have + CHUNK - zs->avail_out);
+        if (ret == Z_STREAM_ERROR) return false;
+    } while (zs->avail_out == 0 || (flush == Z_FINISH && ret == Z_OK));
+    return flush != Z_FINISH || ret == Z_STREAM_END;
+}
+
+bool Deflater::write(const void* data, size_t n) {
+    if (!active) return false;
+    PerfScope timer(PerfMetric::Compress);
+    const Bytef* p = (const Bytef*)data;
+    while (n > 0) {
+        uInt step = (uInt)std::min<size_t>(n, UINT_MAX);
+        zs->next_in = const_cast<Bytef*>(p);
+        zs->avail_in = step;
+        if (!pump(Z_NO_FLUSH)) return false;
+        p += step;
+        n -= step;
+    }
+    return true;
+}
+
+bool Deflater::finish() {
+    if (!active) return false;
+    zs->next_in = nullptr;
+    zs->avail_in = 0;
+    bool ok = pump(Z_FINISH);
+    deflateEnd(zs.get());
+    active = false;
+    return ok;
+}
@@ -0,0 +1,36 @@
+// compress.h
+// --------------------------------
+// zlib compression for the vault payload (applied before encryption).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstddef>
+
+struct z_stream_s;
+
+// One-shot helpers. The input must already be in memory; only the zlib
+// output is produced in fixed-size chunks.
+bool deflate_payload(const std::vector<uint8_t>& in, std::vector<uint8_t>& out, int level = 6);
+bool inflate_payload(const std::vector<uint8_t>& in, std::vector<uint8_t>& out);
+
+// Incremental deflate for producers that generate the input piece by piece
+// (the vault serializer), so the uncompressed payload never exists in full.
+struct Deflater {
+    bool begin(std::vector<uint8_t>& out, int level = 6); // out is cleared and receives the stream
+    bool write(const void* data, size_t n);
+    bool finish();
+
+    Deflater();
+    Deflater(const Deflater&) = delete;
+    Deflater& operator=(const Deflater&) = delete;
+    ~Deflater();
+
+private:
+    bool pump(int flush);
+    std::unique_ptr<z_stream_s> zs;
+    std::vector<uint8_t>* out = nullptr;
+    bool active = false;
+};
@@ -4,8 +4,13 @@
 // Credits: aggeloskwn7 (github)
 // --------------------------------
 #include "crypto.h"
+#include "file_util.h"
+#include "perf.h"
+#include <openssl/crypto.h>
 #include <openssl/evp.h>
+#include <openssl/hmac.h>
 #include <openssl/rand.h>
+#include <cstdio>
 #include <cstring>
 
 namespace {
@@ -21,6 +26,7 @@ bool derive_key_pbkdf2(
     uint32_t iterations,
     std::vector<uint8_t>& out_key
 ) {
+    PerfScope timer(PerfMetric::Kdf);
     out_key.resize(KEY_LEN);
     const EVP_MD* md = EVP_sha256();
     int ok = PKCS5_PBKDF2_HMAC(
@@ -44,6 +50,7 @@ bool aes256gcm_encrypt(
     std::vector<uint8_t>& ciphertext,
     std::vector<uint8_t>& tag
 ) {
+    PerfScope timer(PerfMetric::Encrypt);
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
     if (!ctx) return false;
     bool success = false;
@@ -84,6 +91,19 @@ bool aes256gcm_decrypt(
     const std::vector<uint8_t>& tag,
     std::vector<uint8_t>& plaintext
 ) {
+    return aes256gcm_decrypt(key, iv, ciphertext.data(), ciphertext.size(), aad, tag, plaintext);
+}
+
+bool aes256gcm_decrypt(
+    const std::vector<uint8_t>& key,
+    const std::vector<uint8_t>& iv,
+    const uint8_t* ciphertext,
+    size_t ciphertext_len,
+    const std::vector<uint8_t>& aad,
+    const std::vector<uint8_t>& tag,
+    std::vector<uint8_t>& plaintext
+) {
+    PerfScope timer(PerfMetric::Decrypt);
     EVP_CIPHER_CTX* ctx = EVP_CIPHER_CTX_new();
     if (!ctx) return false;
     bool success = false;
@@ -98,8 +118,8 @@ bool aes256gcm_decrypt(
             if (EVP_DecryptUpdate(ctx, nullptr, &len, aad.data(), static_cast<int>(aad.size())) != 1) break;
         }
 
-        plaintext.resize(ciphertext.size());
-        if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext.data(), static_cast<int>(ciphertext.size())) != 1) break;
+        plaintext.resize(ciphertext_len);
+        if (EVP_DecryptUpdate(ctx, plaintext.data(), &len, ciphertext, static_cast<int>(ciphertext_len)) != 1) break;
         int plaintext_len = len;
 
         if (EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_GCM_SET_TAG, static_cast<int>(tag.size()), const_cast<uint8_t*>(tag.data())) != 1) break;
@@ -116,3 +136,92 @@ bool aes256gcm_decrypt(
     EVP_CIPHER_CTX_free(ctx);
     return success;
 }
+
+bool hmac_sha256(
+    const std::vector<uint8_t>& key,
+    const uint8_t* data,
+    size_t len,
+    std::vector<uint8_t>& out
+) {
+    out.resize(32);
+    unsigned int out_len = 0;
+    if (!HMAC(EVP_sha256(), key.data(), static_cast<int>(key.size()), data, len, out.data(), &out_len)) return false;
+    out.resize(out_len);
+    return true;
+}
+
+std::string to_hex(const std::vector<uint8_t>& b) {
+    static const char* digits = "0123456789abcdef";
+    std::string s;
+    s.reserve(b.size() * 2);
+    for (uint8_t c : b) { s.push_back(digits[c >> 4]); s.push_back(digits[c & 15]); }
+    return s;
+}
+
+bool from_hex(const std::string& s, std::vector<uint8_t>& out) {
+    if (s.size() % 2) return false;
+    out.resize(s.size() / 2);
+    for (size_t i = 0; i < out.size(); i++) {
+        unsigned v = 0;
+        if (std::sscanf(s.c_str() + 2 * i, "%2x", &v) != 1) return false;
+        out[i] = (uint8_t)v;
+    }
+    return true;
+}
+
+bool subkey(const std::vector<uint8_t>& key, const char* label, std::vector<uint8_t>& out) {
+    return hmac_sha256(key, (const uint8_t*)label, std::strlen(label), out);
+}
+
+bool open_key_config(
+    const std::string& config_path,
+    const uint8_t* magic,
+    const std::string& master_password,
+    uint32_t iterations,
+    const char* check_label,
+    std::initializer_list<KeyLabel> keys,
+    const std::function<bool()>& init
+) {
+    auto wipe_keys = [&]() {
+        for (auto& k : keys) {
+            if (!k.key->empty()) OPENSSL_cleanse(k.key->data(), k.key->size());
+            k.key->clear();
+        }
+    };
+
+    // 1) Read config (salt, iterations, key check) or make a new salt
+    std::vector<uint8_t> salt(16), check, file;
+    if (read_file(config_path, file)) {
+        if (file.size() != 4 + 16 + 4 + 32 || std::memcmp(file.data(), magic, 4) != 0) return false;
+        std::memcpy(salt.data(), file.data() + 4, 16);
+        std::memcpy(&iterations, file.data() + 20, 4);
+        check.assign(file.begin() + 24, file.end());
+    }
+    else {
+        if (RAND_bytes(salt.data(), (int)salt.size()) != 1) return false;
+    }
+
+    // 2) One KDF run, everything else is HMAC subkeys
+    std::vector<uint8_t> root, expect;
+    if (!derive_key_pbkdf2(master_password, salt, iterations, root)) return false;
+    bool ok = subkey(root, check_label, expect);
+    for (auto& k : keys) ok = ok && subkey(root, k.label, *k.key);
+    OPENSSL_cleanse(root.data(), root.size());
+    if (!ok) { wipe_keys(); return false; }
+
+    // 3) Existing store: check the password
+    if (!check.empty()) {
+        ok = CRYPTO_memcmp(check.data(), expect.data(), expect.size()) == 0;
+        if (!ok) wipe_keys();
+        return ok;
+    }
+
+    // 3b) New store: let the caller lay it out, config last
+    file.assign(magic, magic + 4);
+    file.insert(file.end(), salt.begin(), salt.end());
+    file.insert(file.end(), (const uint8_t*)&iterations, (const uint8_t*)&iterations + 4);
+    file.insert(file.end(), expect.begin(), expect.end());
+    ok = (!init || init()) && write_file_atomic(config_path, file);
+    if (!ok) wipe_keys();
+    return ok;
+}
@@ -6,6 +6,8 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <functional>
+#include <initializer_list>
 #include <cstdint>
 
 struct EncBlob {
@@ -40,3 +42,47 @@ bool aes256gcm_decrypt(
     const std::vector<uint8_t>& tag,     // 16B
     std::vector<uint8_t>& plaintext
 );
+
+// same, reading the ciphertext in place (e.g. straight out of a file buffer)
+bool aes256gcm_decrypt(
+    const std::vector<uint8_t>& key,
+    const std::vector<uint8_t>& iv,
+    const uint8_t* ciphertext,
+    size_t ciphertext_len,
+    const std::vector<uint8_t>& aad,
+    const std::vector<uint8_t>& tag,
+    std::vector<uint8_t>& plaintext
+);
+
+bool hmac_sha256(
+    const std::vector<uint8_t>& key,
+    const uint8_t* data,
+    size_t len,
+    std::vector<uint8_t>& out            // 32B
+);
+
+std::string to_hex(const std::vector<uint8_t>& bytes);
+bool from_hex(const std::string& hex, std::vector<uint8_t>& out);
+
+// HMAC-SHA256(key, label), used to split one derived key into independent ones
+bool subkey(const std::vector<uint8_t>& key, const char* label, std::vector<uint8_t>& out);
+
+// Key setup for directory-based stores (backups, sharded vaults). The config
+// file holds magic, salt, iterations and a key check. PBKDF2 runs once, every
+// key in `keys` is an HMAC subkey of the result. On first use `init` runs
+// after the keys exist and before the config is written (the config marks the
+// store as created). Fails on a wrong master password or a damaged config.
+struct KeyLabel {
+    const char* label;
+    std::vector<uint8_t>* key;
+};
+
+bool open_key_config(
+    const std::string& config_path,
+    const uint8_t* magic,                // 4B
+    const std::string& master_password,
+    uint32_t iterations,                 // only used when creating
+    const char* check_label,
+    std::initializer_list<KeyLabel> keys,
+    const std::function<bool()>& init = nullptr
+);
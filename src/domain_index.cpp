@@ -0,0 +1,142 @@
+// domain_index.cpp
+// --------------------------------
+// Host normalization and the domain -> entries index.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "domain_index.h"
+#include <algorithm>
+#include <cctype>
+
+namespace {
+    const std::vector<size_t> EMPTY;
+
+    // Second-level labels that act as public suffixes under a country TLD.
+    // Not the full Public Suffix List, just the ones people actually type.
+    bool is_two_part_suffix(const std::string& sld, const std::string& tld) {
+        if (tld.size() != 2) return false;
+        static const char* const SLDS[] = { "co", "com", "net", "org", "gov", "ac", "edu", "ne", "or" };
+        for (auto s : SLDS)
+            if (sld == s) return true;
+        return false;
+    }
+
+    bool is_ipv4(const std::string& host) {
+        return !host.empty() && std::all_of(host.begin(), host.end(),
+            [](unsigned char c) { return std::isdigit(c) || c == '.'; });
+    }
+
+    void insert_sorted(std::vector<size_t>& list, size_t index) {
+        list.insert(std::lower_bound(list.begin(), list.end(), index), index);
+    }
+
+    void erase_from(std::unordered_map<std::string, std::vector<size_t>>& map, const std::string& key, size_t index) {
+        auto it = map.find(key);
+        if (it == map.end()) return;
+        auto& list = it->second;
+        auto pos = std::lower_bound(list.begin(), list.end(), index);
+        if (pos != list.end() && *pos == index) list.erase(pos);
+        if (list.empty()) map.erase(it);
+    }
+
+    void shift_down(std::unordered_map<std::string, std::vector<size_t>>& map, size_t index) {
+        for (auto& kv : map)
+            for (auto& i : kv.second)
+                if (i > index) --i;
+    }
+}
+
+std::string normalize_host(std::string_view website) {
+    size_t b = 0, e = website.size();
+    while (b < e && std::isspace((unsigned char)website[b])) b++;
+    while (e > b && std::isspace((unsigned char)website[e - 1])) e--;
+
+    // scheme, only if "://" comes before any path/query/fragment
+    // ("bank.com/login?r=https://evil.com" has no scheme, its host is bank.com)
+    size_t delim = website.find_first_of("/?#", b);
+    size_t scheme = website.find("://", b);
+    if (scheme != std::string::npos && scheme < e && (delim == std::string::npos || scheme < delim)) b = scheme + 3;
+
+    // path, query, fragment
+    size_t end = website.find_first_of("/?#", b);
+    if (end != std::string::npos && end < e) e = end;
+
+    // userinfo (only inside the authority)
+    size_t at = website.substr(b, e - b).rfind('@');
+    if (at != std::string::npos) b += at + 1;
+
+    std::string host(website.substr(b, e - b));
+
+    // port ("[::1]:8080" keeps its brackets, drops the port)
+    if (!host.empty() && host[0] == '[') {
+        size_t close = host.find(']');
+        if (close != std::string::npos) host.resize(close + 1);
+    }
+    else {
+        size_t colon = host.rfind(':');
+        if (colon != std::string::npos) host.resize(colon);
+    }
+
+    std::transform(host.begin(), host.end(), host.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+    while (!host.empty() && host.back() == '.') host.pop_back();
+    if (host.compare(0, 4, "www.") == 0) host.erase(0, 4);
+    return host;
+}
+
+std::string registrable_domain(const std::string& host) {
+    if (host.empty() || host[0] == '[' || is_ipv4(host)) return host;
+
+    size_t last = host.rfind('.');
+    if (last == std::string::npos || last == 0) return host;
+    size_t second = host.rfind('.', last - 1);
+    if (second == std::string::npos) return host;
+
+    std::string sld = host.substr(second + 1, last - second - 1);
+    std::string tld = host.substr(last + 1);
+    if (is_two_part_suffix(sld, tld) && second > 0) {
+        size_t third = host.rfind('.', second - 1);
+        return third == std::string::npos ? host : host.substr(third + 1);
+    }
+    return host.substr(second + 1);
+}
+
+void DomainIndex::clear() {
+    by_host.clear();
+    by_domain.clear();
+}
+
+void DomainIndex::add(std::string_view website, size_t index) {
+    std::string h = normalize_host(website);
+    if (h.empty()) return;
+    insert_sorted(by_domain[registrable_domain(h)], index);
+    insert_sorted(by_host[std::move(h)], index);
+}
+
+void DomainIndex::remove(std::string_view website, size_t index) {
+    std::string h = normalize_host(website);
+    if (!h.empty()) {
+        erase_from(by_domain, registrable_domain(h), index);
+        erase_from(by_host, h, index);
+    }
+    shift_down(by_host, index);
+    shift_down(by_domain, index);
+}
+
+void DomainIndex::move(std::string_view from, std::string_view to, size_t index) {
+    std::string h = normalize_host(from);
+    if (!h.empty()) {
+        erase_from(by_domain, registrable_domain(h), index);
+        erase_from(by_host, h, index);
+    }
+    add(to, index);
+}
+
+const std::vector<size_t>& DomainIndex::host(std::string_view website) const {
+    auto it = by_host.find(normalize_host(website));
+    return it == by_host.end() ? EMPTY : it->second;
+}
+
+const std::vector<size_t>& DomainIndex::domain(std::string_view website) const {
+    auto it = by_domain.find(registrable_domain(normalize_host(website)));
+    return it == by_domain.end() ? EMPTY : it->second;
+}
@@ -0,0 +1,34 @@
+// domain_index.h
+// --------------------------------
+// Normalized-domain index over vault entries.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <cstddef>
+
+// "https://www.Accounts.Example.com:443/login" -> "accounts.example.com"
+std::string normalize_host(std::string_view website);
+
+// "accounts.example.com" -> "example.com", "shop.example.co.uk" -> "example.co.uk"
+std::string registrable_domain(const std::string& host);
+
+// Maps hosts and registrable domains to entry indices (kept in ascending order).
+struct DomainIndex {
+    std::unordered_map<std::string, std::vector<size_t>> by_host;
+    std::unordered_map<std::string, std::vector<size_t>> by_domain;
+
+    void clear();
+    void add(std::string_view website, size_t index);
+    // drops `index` and shifts every index above it down by one (matches vector::erase)
+    void remove(std::string_view website, size_t index);
+    // the entry at `index` changed its website
+    void move(std::string_view from, std::string_view to, size_t index);
+
+    // both take free text and normalize it first, lookups are a single hash probe
+    const std::vector<size_t>& host(std::string_view website) const;
+    const std::vector<size_t>& domain(std::string_view website) const;
+};
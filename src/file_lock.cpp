@@ -0,0 +1,65 @@
+// file_lock.cpp
+// --------------------------------
+// Cross-process exclusive lock held on a small sidecar file.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "file_lock.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+bool FileLock::lock(const std::string& path) {
+    unlock();
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    OVERLAPPED ov{};
+    if (!LockFileEx(f, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov)) { CloseHandle(f); return false; }
+    handle = f;
+#else
+    int f = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (f < 0) return false;
+    int rc;
+    while ((rc = flock(f, LOCK_EX)) != 0 && errno == EINTR) {}
+    if (rc != 0) { ::close(f); return false; }
+    fd = f;
+#endif
+    return true;
+}
+
+void FileLock::unlock() {
+#ifdef _WIN32
+    if (!handle) return;
+    OVERLAPPED ov{};
+    UnlockFileEx(handle, 0, 1, 0, &ov);
+    CloseHandle(handle);
+    handle = nullptr;
+#else
+    if (fd < 0) return;
+    flock(fd, LOCK_UN);
+    ::close(fd);
+    fd = -1;
+#endif
+}
+
+bool FileLock::locked() const {
+#ifdef _WIN32
+    return handle != nullptr;
+#else
+    return fd >= 0;
+#endif
+}
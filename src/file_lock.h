@@ -0,0 +1,22 @@
+// file_lock.h
+// --------------------------------
+// Cross-process exclusive lock held on a small sidecar file.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+
+// Advisory: only processes that also use FileLock are kept out. The lock is
+// released on unlock(), on destruction, or by the OS if the process dies.
+struct FileLock {
+#ifdef _WIN32
+    void* handle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    bool lock(const std::string& path); // blocks until the lock is ours, creates the file if needed
+    void unlock();
+    bool locked() const;
+    ~FileLock() { unlock(); }
+};
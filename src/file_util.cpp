@@ -0,0 +1,70 @@
+// file_util.cpp
+// --------------------------------
+// Small whole-file helpers shared by the storage modules.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "file_util.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace fs = std::filesystem;
+
+bool read_file(const std::string& path, std::vector<uint8_t>& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    out.assign(std::istreambuf_iterator<char>(f), {});
+    return true;
+}
+
+bool write_file_synced(const std::string& path, const std::vector<uint8_t>& data) {
+#ifdef _WIN32
+    HANDLE f = CreateFileA(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (f == INVALID_HANDLE_VALUE) return false;
+    bool ok = true;
+    for (size_t off = 0; ok && off < data.size();) {
+        DWORD n = 0, want = (DWORD)std::min<size_t>(data.size() - off, 1u << 30);
+        ok = WriteFile(f, data.data() + off, want, &n, nullptr) && n == want;
+        off += n;
+    }
+    ok = ok && FlushFileBuffers(f);
+    CloseHandle(f);
+#else
+    int f = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (f < 0) return false;
+    bool ok = true;
+    for (size_t off = 0; ok && off < data.size();) {
+        ssize_t n = ::write(f, data.data() + off, data.size() - off);
+        if (n < 0 && errno == EINTR) continue;
+        ok = n > 0;
+        if (ok) off += (size_t)n;
+    }
+    ok = ok && ::fsync(f) == 0;
+    ok = (::close(f) == 0) && ok;
+#endif
+    if (!ok) { std::error_code ec; fs::remove(path, ec); }
+    return ok;
+}
+
+bool write_file_atomic(const std::string& path, const std::vector<uint8_t>& data) {
+    std::string tmp = path + ".tmp";
+    if (!write_file_synced(tmp, data)) return false;
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    return !ec;
+}
@@ -0,0 +1,18 @@
+// file_util.h
+// --------------------------------
+// Small whole-file helpers shared by the storage modules.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+bool read_file(const std::string& path, std::vector<uint8_t>& out);
+
+// writes and flushes to disk (FlushFileBuffers / fsync) before returning, so a
+// rename that follows can't survive a crash while the data doesn't
+bool write_file_synced(const std::string& path, const std::vector<uint8_t>& data);
+
+// synced write + rename, readers never see a half written file under its final name
+bool write_file_atomic(const std::string& path, const std::vector<uint8_t>& data);
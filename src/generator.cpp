@@ -0,0 +1,183 @@
+// generator.cpp
+// --------------------------------
+// CSPRNG password / passphrase generator.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "generator.h"
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+namespace {
+    const char* const AMBIGUOUS = "0Oo1lI|`'\"";
+    constexpr int MAX_ATTEMPTS = 1000; // require_each retries, only hit by absurd policies
+
+    struct Alphabet {
+        std::string chars;
+        uint8_t class_of[256] = {}; // bit per class the char came from
+        uint8_t required = 0;
+    };
+
+    void add_class(Alphabet& a, const std::string& set, uint8_t bit, bool exclude_ambiguous) {
+        bool any = false;
+        for (unsigned char c : set) {
+            if (exclude_ambiguous && std::strchr(AMBIGUOUS, c)) continue;
+            if (a.class_of[c]) continue; // duplicate in a custom symbol set
+            a.class_of[c] = bit;
+            a.chars.push_back((char)c);
+            any = true;
+        }
+        if (any) a.required |= bit;
+    }
+
+    Alphabet build_alphabet(const PasswordPolicy& p) {
+        Alphabet a;
+        if (p.lower) add_class(a, "abcdefghijklmnopqrstuvwxyz", 1, p.exclude_ambiguous);
+        if (p.upper) add_class(a, "ABCDEFGHIJKLMNOPQRSTUVWXYZ", 2, p.exclude_ambiguous);
+        if (p.digits) add_class(a, "0123456789", 4, p.exclude_ambiguous);
+        if (p.symbols) add_class(a, p.symbol_set, 8, p.exclude_ambiguous);
+        return a;
+    }
+
+    int popcount(uint8_t v) {
+        int n = 0;
+        for (; v; v &= v - 1) n++;
+        return n;
+    }
+
+    std::string generate_passphrase(const PasswordPolicy& p, RandomPool& rng) {
+        if (!p.wordlist || p.wordlist->empty()) return "";
+        std::string out;
+        for (int i = 0; i < p.words; i++) {
+            if (i) out += p.separator;
+            out += (*p.wordlist)[rng.uniform((uint32_t)p.wordlist->size())];
+        }
+        return rng.ok ? out : std::string();
+    }
+
+    std::string generate_from(const PasswordPolicy& p, const Alphabet& a, RandomPool& rng) {
+        if (p.length <= 0 || a.chars.empty()) return "";
+        if (p.require_each && popcount(a.required) > p.length) return "";
+
+        std::string pw(p.length, '\0');
+        for (int attempt = 0; attempt < MAX_ATTEMPTS; attempt++) {
+            uint8_t seen = 0;
+            for (auto& c : pw) {
+                c = a.chars[rng.uniform((uint32_t)a.chars.size())];
+                seen |= a.class_of[(unsigned char)c];
+            }
+            if (!rng.ok) break;
+            // rejecting the whole draw keeps the result uniform over valid passwords
+            if (!p.require_each || seen == a.required) return pw;
+        }
+        OPENSSL_cleanse(&pw[0], pw.size());
+        return "";
+    }
+}
+
+RandomPool::~RandomPool() {
+    if (!buf.empty()) OPENSSL_cleanse(buf.data(), buf.size());
+}
+
+bool RandomPool::refill() {
+    if (buf.empty()) buf.resize(BLOCK);
+    if (RAND_bytes(buf.data(), (int)buf.size()) != 1) {
+        ok = false;
+        return false;
+    }
+    pos = 0;
+    return true;
+}
+
+uint8_t RandomPool::next_byte() {
+    if (pos >= buf.size() && !refill()) return 0;
+    uint8_t b = buf[pos];
+    buf[pos++] = 0;
+    return b;
+}
+
+uint32_t RandomPool::uniform(uint32_t n) {
+    if (n <= 1) return 0;
+    if (n <= 256) {
+        // reject the top 256 % n byte values
+        const uint32_t limit = 256 - 256 % n;
+        for (;;) {
+            uint32_t b = next_byte();
+            if (!ok) return 0;
+            if (b < limit) return b % n;
+        }
+    }
+    const uint64_t limit = (uint64_t(1) << 32) - (uint64_t(1) << 32) % n;
+    for (;;) {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; i++) v = v << 8 | next_byte();
+        if (!ok) return 0;
+        if (v < limit) return v % n;
+    }
+}
+
+std::string generate_password(const PasswordPolicy& policy, RandomPool& rng) {
+    if (policy.words > 0) return generate_passphrase(policy, rng);
+    return generate_from(policy, build_alphabet(policy), rng);
+}
+
+std::string generate_password(const PasswordPolicy& policy) {
+    RandomPool rng;
+    return generate_password(policy, rng);
+}
+
+bool generate_passwords(const PasswordPolicy& policy, size_t count, std::vector<std::string>& out, unsigned threads) {
+    out.assign(count, std::string());
+    if (count == 0) return true;
+
+    const Alphabet alphabet = build_alphabet(policy);
+    if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, count / 1024));
+
+    // each worker owns a pool and a slice of the output
+    std::vector<char> failed(threads, 0);
+    auto work = [&](unsigned t, size_t b, size_t e) {
+        RandomPool rng;
+        for (size_t i = b; i < e; i++) {
+            out[i] = policy.words > 0 ? generate_passphrase(policy, rng) : generate_from(policy, alphabet, rng);
+            if (out[i].empty()) { failed[t] = 1; return; }
+        }
+    };
+
+    size_t chunk = (count + threads - 1) / threads;
+    if (threads == 1) {
+        work(0, 0, count);
+    }
+    else {
+        std::vector<std::thread> pool;
+        for (unsigned t = 0; t < threads && t * chunk < count; t++)
+            pool.emplace_back(work, t, t * chunk, std::min(count, (t + 1) * chunk));
+        for (auto& th : pool) th.join();
+    }
+
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+        for (auto& s : out) if (!s.empty()) OPENSSL_cleanse(&s[0], s.size());
+        out.clear();
+        return false;
+    }
+    return true;
+}
+
+bool load_wordlist(const std::string& path, std::vector<std::string>& out) {
+    std::ifstream f(path);
+    if (!f) return false;
+    out.clear();
+    std::string line;
+    while (std::getline(f, line)) {
+        while (!line.empty() && std::isspace((unsigned char)line.back())) line.pop_back();
+        size_t tab = line.find('\t');
+        if (tab != std::string::npos) line.erase(0, tab + 1);
+        if (!line.empty()) out.push_back(line);
+    }
+    return !out.empty();
+}
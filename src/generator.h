@@ -0,0 +1,56 @@
+// generator.h
+// --------------------------------
+// CSPRNG password / passphrase generator.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+struct PasswordPolicy {
+    int length = 16;
+    bool lower = true;
+    bool upper = true;
+    bool digits = true;
+    bool symbols = true;
+    bool require_each = true;       // at least one character from every enabled class
+    bool exclude_ambiguous = false; // drop 0 O o 1 l I | ` ' " and friends
+    std::string symbol_set = "!@#$%^&*()-_=+[]{}<>?";
+
+    // passphrase mode when words > 0 (needs a wordlist)
+    int words = 0;
+    std::string separator = "-";
+    const std::vector<std::string>* wordlist = nullptr;
+};
+
+// Buffered RAND_bytes. Pulls randomness in large blocks and maps it to
+// ranges with rejection sampling, so there is no modulo bias.
+struct RandomPool {
+    static constexpr size_t BLOCK = 64 * 1024;
+
+    bool ok = true; // false once RAND_bytes has failed
+    uint32_t uniform(uint32_t n); // uniform in [0, n)
+
+    RandomPool() = default;
+    RandomPool(const RandomPool&) = delete;
+    RandomPool& operator=(const RandomPool&) = delete;
+    ~RandomPool();
+
+private:
+    uint8_t next_byte();
+    bool refill();
+    std::vector<uint8_t> buf;
+    size_t pos = 0;
+};
+
+// Returns an empty string if the policy can't be satisfied or the RNG failed.
+std::string generate_password(const PasswordPolicy& policy, RandomPool& rng);
+std::string generate_password(const PasswordPolicy& policy);
+
+// Bulk generation for rotation jobs, split across all cores (threads = 0).
+bool generate_passwords(const PasswordPolicy& policy, size_t count, std::vector<std::string>& out, unsigned threads = 0);
+
+// One word per line; EFF-style "11111<tab>word" lines are accepted too.
+bool load_wordlist(const std::string& path, std::vector<std::string>& out);
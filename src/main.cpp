@@ -16,6 +16,11 @@
 
 #include "vault.h"
 #include "crypto.h"
+#include "audit.h"
+#include "breach.h"
+#include "generator.h"
+#include "merge.h"
+#include "perf.h"
 
 #include "imgui.h"
 #include "backends/imgui_impl_glfw.h"
@@ -27,6 +32,8 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <future>
+#include <cstdio>
 #include <shlobj.h>
 #include <shellapi.h>
 
@@ -50,6 +57,11 @@ std::string getVaultPath() {
     return "vault.dat"; 
 }
 
+// Optional offline breach corpus (HIBP "ordered by hash" SHA-1 dump), next to the vault
+std::string getBreachCorpusPath() {
+    return (std::filesystem::path(getVaultPath()).parent_path() / "pwned-passwords-sha1.txt").string();
+}
+
 void DragWindow(GLFWwindow* window)
 {
     static bool dragging = false;
@@ -74,29 +86,24 @@ void DragWindow(GLFWwindow* window)
 }
 
 std::string GenerateStrongPassword(int length) {
-    const std::string chars =
-        "abcdefghijklmnopqrstuvwxyz"
-        "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
-        "0123456789"
-        "!@#$%^&*()-_=+[]{}<>?";
-    std::string pw;
-    pw.reserve(length);
-    for (int i = 0; i < length; i++) {
-        pw.push_back(chars[rand() % chars.size()]);
-    }
-    return pw;
+    PasswordPolicy policy;
+    policy.length = length;
+    return generate_password(policy);
 }
 
 
 
 // Globals
 Vault g_vault;
+Vault g_base; // g_vault as last loaded or saved, the ancestor when merging in other writers' changes
 std::string g_master;
 bool g_unlocked = false;
 bool g_firstRun = false;
 std::string g_status;
 std::time_t now = std::time(nullptr);
 bool showAbout = false;
+BreachCorpus g_breach;
+std::future<bool> g_filterJob; // Bloom filter sidecar being built in the background
 
 // Buffers
 static char masterBuf[128];
@@ -109,7 +116,90 @@ bool file_exists(const std::string& path) {
     return f.good();
 }
 
-int main() {
+// Saves g_vault, merging in whatever another window or machine committed in
+// the meantime. On failure the changes stay in memory (still dirty) and the
+// status line says so; the next save or the retry button tries again.
+void syncVault(const std::string& vaultPath) {
+    MergeResult r;
+    if (!sync_vault(g_vault, g_base, vaultPath, g_master, &r)) {
+        g_vault.dirty = true;
+        g_status = "Could not save the vault. Your changes are kept until the next save.";
+        return;
+    }
+    size_t edited = 0, deleted = 0;
+    for (auto& c : r.conflicts) (c.kind == ConflictKind::BothEdited ? edited : deleted)++;
+    g_status.clear();
+    if (edited)
+        g_status = std::to_string(edited) + " entries were also changed elsewhere, the newest edit was kept.";
+    if (deleted)
+        g_status += (g_status.empty() ? "" : " ") + std::to_string(deleted) + " edited entries were deleted elsewhere and have been kept.";
+}
+
+// Polled every frame, so the corpus gets its new filter even when the
+// Check Password popup was closed during the build
+void pollBreachFilter(const std::string& breachPath) {
+    if (!g_filterJob.valid() || g_filterJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready) return;
+    if (!g_filterJob.get()) g_status = "Could not build the breach filter, breach checks stay slower.";
+    g_breach.open(breachPath); // reopen so the new sidecar is picked up
+}
+
+// Debug overlay (F2), shows the perf metrics collected while it is open
+void drawPerfOverlay(bool* open) {
+    ImGui::SetNextWindowSize(ImVec2(520, 420), ImGuiCond_FirstUseEver);
+    if (!ImGui::Begin("Performance", open, ImGuiWindowFlags_NoCollapse | ImGuiWindowFlags_NoSavedSettings)) {
+        ImGui::End();
+        return;
+    }
+
+    static float samples[PERF_RECENT];
+    const PerfMetric frames[] = { PerfMetric::FrameBuild, PerfMetric::FrameRender };
+    for (PerfMetric m : frames) {
+        int n = perf_recent(m, samples, PERF_RECENT);
+        PerfStats st = perf_stats(m);
+        char label[64];
+        snprintf(label, sizeof(label), "%s\n%.2f ms avg", perf_name(m), st.count ? st.total_us / 1000.0 / st.count : 0.0);
+        ImGui::PlotLines(label, samples, n, 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 50));
+    }
+
+    if (ImGui::BeginTable("perf_metrics", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
+        ImGui::TableSetupColumn("Metric");
+        ImGui::TableSetupColumn("Count");
+        ImGui::TableSetupColumn("Avg ms");
+        ImGui::TableSetupColumn("Min ms");
+        ImGui::TableSetupColumn("Max ms");
+        ImGui::TableHeadersRow();
+        for (int i = 0; i < (int)PerfMetric::Count; i++) {
+            PerfStats st = perf_stats((PerfMetric)i);
+            if (!st.count) continue;
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(perf_name((PerfMetric)i));
+            ImGui::TableNextColumn(); ImGui::Text("%llu", (unsigned long long)st.count);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.total_us / 1000.0 / st.count);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.min_us / 1000.0);
+            ImGui::TableNextColumn(); ImGui::Text("%.3f", st.max_us / 1000.0);
+        }
+        ImGui::EndTable();
+    }
+
+    ImGui::Spacing();
+    for (int i = 0; i < (int)PerfCounter::Count; i++)
+        if (perf_available((PerfCounter)i)) ImGui::Text("%s: %llu", perf_name((PerfCounter)i), (unsigned long long)perf_counter((PerfCounter)i));
+
+    ImGui::Spacing();
+    if (ImGui::Button("Reset")) perf_reset();
+    ImGui::SameLine();
+    if (ImGui::Button("Copy JSON")) ImGui::SetClipboardText(perf_to_json().c_str());
+    ImGui::End();
+}
+
+int main(int argc, char** argv) {
+    // --perf <file.json> collects metrics for the whole session and writes them on exit
+    std::string perfDumpPath;
+    for (int i = 1; i + 1 < argc; i++)
+        if (std::string(argv[i]) == "--perf") perfDumpPath = argv[i + 1];
+    if (!perfDumpPath.empty()) perf_set_enabled(true);
+    bool showPerf = false;
+
     if (!glfwInit()) return -1;
 
     glfwWindowHint(GLFW_DECORATED, GLFW_FALSE);               
@@ -157,11 +247,15 @@ int main() {
 
     std::string vaultPath = getVaultPath();
     g_firstRun = !file_exists(vaultPath);
+    std::string breachPath = getBreachCorpusPath();
+    g_breach.open(breachPath);
 
     // Main loop
     while (!glfwWindowShouldClose(window)) {
         glfwPollEvents();
+        pollBreachFilter(breachPath);
 
+        PerfScope frameBuild(PerfMetric::FrameBuild);
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
         ImGui::NewFrame();
@@ -170,6 +264,10 @@ int main() {
             SetWindowLong(hwnd, GWL_EXSTYLE,
                 exStyle | WS_EX_LAYERED | (clickThrough ? WS_EX_TRANSPARENT : 0));
         }
+        if (GetAsyncKeyState(VK_F2) & 1) {
+            showPerf = !showPerf;
+            if (showPerf) perf_set_enabled(true);
+        }
 
         if (!g_unlocked) {
             ImVec2 winSize(420, 220);
@@ -190,7 +288,7 @@ int main() {
                 if (ImGui::Button("Create Vault", ImVec2(-1, 0))) {
                     g_master = masterBuf;
                     g_unlocked = true;
-                    g_status = "New vault created.";
+                    g_status.clear(); // the unlocked view shows g_status as an error line
                 }
             }
             else {
@@ -199,9 +297,10 @@ int main() {
 
                 if (ImGui::Button("Unlock", ImVec2(-1, 0))) {
                     if (load_vault(g_vault, vaultPath, masterBuf)) {
+                        vault_copy(g_vault, g_base);
                         g_master = masterBuf;
                         g_unlocked = true;
-                        g_status = "Vault unlocked.";
+                        g_status.clear();
                     }
                     else {
                         g_status = "Failed to unlock. Wrong password?";
@@ -314,9 +413,28 @@ int main() {
             if (ImGui::Button("Check Password")) {
                 showPasswordChecker = true;
             }
+            ImGui::SameLine();
+
+            // Audit button
+            static bool showAudit = false;
+            static AuditReport auditReport;
+            if (ImGui::Button("Audit Vault")) {
+                AuditOptions opt;
+                opt.breach = g_breach.is_open() ? &g_breach : nullptr;
+                auditReport = audit_vault(g_vault, opt);
+                showAudit = true;
+            }
             ImGui::Spacing();
 
 
+            if (!g_status.empty()) {
+                ImGui::TextColored(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), "%s", g_status.c_str());
+                if (g_vault.dirty) {
+                    ImGui::SameLine();
+                    if (ImGui::Button("Retry Save")) syncVault(vaultPath);
+                }
+            }
+
             if (g_vault.entries.empty()) {
                 ImGui::Text("You have no saved passwords.");
             }
@@ -326,8 +444,8 @@ int main() {
             ImGui::InputText("Password", passBuf, sizeof(passBuf), ImGuiInputTextFlags_Password);
 
             if (ImGui::Button("Add Entry", ImVec2(-1, 0))) {
-                g_vault.entries.push_back({ siteBuf, userBuf, passBuf });
-                save_vault(g_vault, vaultPath, g_master);
+                vault_add(g_vault, siteBuf, userBuf, passBuf);
+                syncVault(vaultPath);
                 siteBuf[0] = userBuf[0] = passBuf[0] = '\0';
             }
 
@@ -379,11 +497,11 @@ int main() {
                 static int deleteIndex = -1;
 
                 for (size_t i = 0; i < g_vault.entries.size(); i++) {
-                    auto& e = g_vault.entries[i];
+                    auto e = vault_entry(g_vault, i);
 
                     if (!query.empty()) {
-                        std::string siteLower = e.website;
-                        std::string userLower = e.username;
+                        std::string siteLower(e.website);
+                        std::string userLower(e.username);
                         std::transform(siteLower.begin(), siteLower.end(), siteLower.begin(), ::tolower);
                         std::transform(userLower.begin(), userLower.end(), userLower.begin(), ::tolower);
 
@@ -396,11 +514,11 @@ int main() {
                         showPw.resize(g_vault.entries.size(), false);
 
                     ImGui::TableNextRow();
-                    ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(e.website.c_str());
-                    ImGui::TableSetColumnIndex(1); ImGui::TextUnformatted(e.username.c_str());
+                    ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(e.website.data());
+                    ImGui::TableSetColumnIndex(1); ImGui::TextUnformatted(e.username.data());
 
                     ImGui::TableSetColumnIndex(2);
-                    if (showPw[i]) ImGui::TextUnformatted(e.password.c_str());
+                    if (showPw[i]) ImGui::TextUnformatted(e.password.data());
                     else ImGui::Text("********");
 
                     ImGui::TableSetColumnIndex(3);
@@ -413,7 +531,7 @@ int main() {
                     }
                     ImGui::SameLine();
                     if (ImGui::Button(("Copy##" + std::to_string(i)).c_str())) {
-                        glfwSetClipboardString(window, e.password.c_str());
+                        glfwSetClipboardString(window, e.password.data());
                     }
                     ImGui::SameLine();
                     if (ImGui::Button(("Delete##" + std::to_string(i)).c_str())) {
@@ -429,8 +547,8 @@ int main() {
 
                     if (ImGui::Button("Yes", ImVec2(100, 0))) {
                         if (deleteIndex >= 0 && deleteIndex < (int)g_vault.entries.size()) {
-                            g_vault.entries.erase(g_vault.entries.begin() + deleteIndex);
-                            save_vault(g_vault, vaultPath, g_master);
+                            vault_remove(g_vault, deleteIndex);
+                            syncVault(vaultPath);
                         }
                         deleteIndex = -1;
                         ImGui::CloseCurrentPopup();
@@ -474,35 +592,28 @@ int main() {
                 ImGui::InputText("##check_pw", testPassword, sizeof(testPassword));
 
                 if (ImGui::Button("Check Strength", ImVec2(150, 0))) {
-                    int score = 0;
-                    std::string pw = testPassword;
-
-                    bool hasLower = std::any_of(pw.begin(), pw.end(), ::islower);
-                    bool hasUpper = std::any_of(pw.begin(), pw.end(), ::isupper);
-                    bool hasDigit = std::any_of(pw.begin(), pw.end(), ::isdigit);
-                    bool hasSymbol = std::any_of(pw.begin(), pw.end(), [](unsigned char c) { return std::ispunct(c); });
-
-                    if (pw.length() >= 8) score++;
-                    if (pw.length() >= 12) score++;
-                    if (hasLower && hasUpper) score++;
-                    if (hasDigit) score++;
-                    if (hasSymbol) score++;
-
-                    if (score <= 2) {
-                        strengthLabel = "Weak";
-                        strengthColor = ImVec4(0.9f, 0.2f, 0.2f, 1.0f);
+                    Strength strength = strength_from_entropy(estimate_entropy(testPassword));
+                    strengthLabel = strength_label(strength);
+
+                    uint32_t breachCount = 0;
+                    if (g_breach.is_open() && g_breach.contains(testPassword, &breachCount)) {
+                        strengthLabel = "Breached (seen " + std::to_string(breachCount) + " times)";
+                        strength = Strength::Weak;
                     }
-                    else if (score == 3) {
-                        strengthLabel = "Medium";
+
+                    switch (strength) {
+                    case Strength::Weak:
+                        strengthColor = ImVec4(0.9f, 0.2f, 0.2f, 1.0f);
+                        break;
+                    case Strength::Medium:
                         strengthColor = ImVec4(0.95f, 0.75f, 0.2f, 1.0f);
-                    }
-                    else if (score == 4) {
-                        strengthLabel = "Strong";
+                        break;
+                    case Strength::Strong:
                         strengthColor = ImVec4(0.2f, 0.8f, 0.3f, 1.0f);
-                    }
-                    else {
-                        strengthLabel = "Very Strong";
+                        break;
+                    default:
                         strengthColor = ImVec4(0.1f, 0.9f, 0.4f, 1.0f);
+                        break;
                     }
                 }
 
@@ -513,6 +624,17 @@ int main() {
                     ImGui::TextColored(strengthColor, "%s", strengthLabel.c_str());
                 }
 
+                // one-time Bloom filter build so most breach checks skip the dump entirely
+                if (g_filterJob.valid()) {
+                    ImGui::TextDisabled("Building breach filter...");
+                }
+                else if (g_breach.is_open() && !g_breach.has_filter()) {
+                    // the corpus stays open meanwhile: the job maps it read-only on its own and
+                    // writes a separate sidecar file, so checks keep working, just slower
+                    if (ImGui::Button("Build Breach Filter", ImVec2(180, 0)))
+                        g_filterJob = std::async(std::launch::async, [breachPath] { return build_breach_filter(breachPath); });
+                }
+
                 ImGui::Separator();
                 ImGui::Text("Need a strong one?");
                 if (ImGui::Button("Generate Password", ImVec2(180, 0))) {
@@ -540,6 +662,74 @@ int main() {
                 ImGui::EndPopup();
             }
 
+            // Vault Audit Popup
+            if (showAudit) {
+                ImGui::OpenPopup("Vault Audit");
+            }
+
+            ImGui::SetNextWindowSize(ImVec2(700, 420), ImGuiCond_Appearing);
+            if (ImGui::BeginPopupModal("Vault Audit", &showAudit)) {
+                ImGui::Text("Weak: %zu   Reused: %zu   Older than a year: %zu   Breached: %zu",
+                    auditReport.weak, auditReport.reused, auditReport.stale, auditReport.breached);
+                ImGui::Separator();
+
+                if (ImGui::BeginTable("audit_table", 5,
+                    ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_Sortable | ImGuiTableFlags_ScrollY,
+                    ImVec2(0, -ImGui::GetFrameHeightWithSpacing()))) {
+
+                    ImGui::TableSetupColumn("Website", ImGuiTableColumnFlags_NoSort);
+                    ImGui::TableSetupColumn("Username", ImGuiTableColumnFlags_NoSort);
+                    ImGui::TableSetupColumn("Strength", ImGuiTableColumnFlags_DefaultSort);
+                    ImGui::TableSetupColumn("Reused");
+                    ImGui::TableSetupColumn("Age (days)");
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableHeadersRow();
+
+                    if (ImGuiTableSortSpecs* specs = ImGui::TableGetSortSpecs()) {
+                        if (specs->SpecsDirty && specs->SpecsCount > 0) {
+                            static const AuditSort columns[] = { AuditSort::Index, AuditSort::Index, AuditSort::Entropy, AuditSort::Reuse, AuditSort::Age };
+                            const ImGuiTableColumnSortSpecs& col = specs->Specs[0];
+                            sort_audit(auditReport, columns[col.ColumnIndex], col.SortDirection == ImGuiSortDirection_Descending);
+                            specs->SpecsDirty = false;
+                        }
+                    }
+
+                    ImGuiListClipper clipper;
+                    clipper.Begin((int)auditReport.items.size());
+                    while (clipper.Step()) {
+                        for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                            const AuditItem& it = auditReport.items[row];
+                            if (it.index >= g_vault.entries.size()) continue;
+                            auto e = vault_entry(g_vault, it.index);
+
+                            ImGui::TableNextRow();
+                            ImGui::TableSetColumnIndex(0); ImGui::TextUnformatted(e.website.data());
+                            ImGui::TableSetColumnIndex(1); ImGui::TextUnformatted(e.username.data());
+                            ImGui::TableSetColumnIndex(2);
+                            if (it.breached) ImGui::TextColored(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), "Breached");
+                            else if (it.weak) ImGui::TextColored(ImVec4(0.9f, 0.2f, 0.2f, 1.0f), "%s (%.0f bits)", strength_label(it.strength), it.entropy);
+                            else ImGui::Text("%s (%.0f bits)", strength_label(it.strength), it.entropy);
+                            ImGui::TableSetColumnIndex(3);
+                            if (it.reused) ImGui::TextColored(ImVec4(0.95f, 0.75f, 0.2f, 1.0f), "%zu times", it.reuse_count);
+                            else ImGui::Text("-");
+                            ImGui::TableSetColumnIndex(4);
+                            if (it.stale) ImGui::TextColored(ImVec4(0.95f, 0.75f, 0.2f, 1.0f), "%d", it.age_days);
+                            else ImGui::Text("%d", it.age_days);
+                        }
+                    }
+
+                    ImGui::EndTable();
+                }
+
+                if (ImGui::Button("Close", ImVec2(100, 0))) {
+                    showAudit = false;
+                    auditReport = AuditReport();
+                    ImGui::CloseCurrentPopup();
+                }
+
+                ImGui::EndPopup();
+            }
+
             ImGui::End(); 
             ImGui::PopStyleVar(3);
 
@@ -586,18 +776,29 @@ int main() {
         }
 
 
+        if (showPerf) drawPerfOverlay(&showPerf);
+        if (!showPerf && perfDumpPath.empty()) perf_set_enabled(false);
+
         // Render
         ImGui::Render();
+        frameBuild.stop();
+
+        // swap is left out on purpose, with vsync on it would only measure the wait
+        PerfScope frameRender(PerfMetric::FrameRender);
         int display_w, display_h;
         glfwGetFramebufferSize(window, &display_w, &display_h);
         glViewport(0, 0, display_w, display_h);
         glClearColor(0.0f, 0.0f, 0.0f, 0.0f); // clear
         glClear(GL_COLOR_BUFFER_BIT);
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        frameRender.stop();
         glfwSwapBuffers(window);
     }
 
     // Cleanup
+    if (!perfDumpPath.empty()) perf_dump(perfDumpPath);
+    vault_lock(g_vault);
+    vault_lock(g_base);
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -0,0 +1,188 @@
+// merge.cpp
+// --------------------------------
+// Reconciling two copies of a vault (e.g. synced between machines).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "merge.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    using IdMap = std::unordered_map<uint64_t, size_t>;
+    using TombMap = std::unordered_map<uint64_t, std::time_t>;
+
+    IdMap index_ids(const Vault& v) {
+        IdMap m;
+        m.reserve(v.entries.size());
+        for (size_t i = 0; i < v.entries.size(); i++) m.emplace(v.entries[i].id, i);
+        return m;
+    }
+
+    void add_tombstones(TombMap& m, const Vault& v) {
+        for (auto& t : v.tombstones) {
+            auto& at = m[t.id];
+            at = std::max(at, t.deleted_at);
+        }
+    }
+
+    bool same_content(const EntryView& a, const EntryView& b) {
+        return a.website == b.website && a.username == b.username && a.password == b.password;
+    }
+
+    struct Merger {
+        const Vault& local;
+        const Vault& remote;
+        const Vault* base;
+        Vault& out;
+        MergeResult& r;
+        IdMap local_ids, remote_ids, base_ids;
+        TombMap local_tombs, remote_tombs;
+
+        const EntryView* find_base(uint64_t id, EntryView& tmp) const {
+            if (!base) return nullptr;
+            auto it = base_ids.find(id);
+            if (it == base_ids.end()) return nullptr;
+            tmp = vault_entry(*base, it->second);
+            return &tmp;
+        }
+
+        // present on both sides
+        void both(const EntryView& l, const EntryView& rm) {
+            if (same_content(l, rm)) {
+                EntryView e = l;
+                e.modified_at = std::max(l.modified_at, rm.modified_at);
+                vault_insert(out, e);
+                return;
+            }
+
+            EntryView tmp;
+            const EntryView* b = find_base(l.id, tmp);
+            if (b && same_content(*b, l)) { vault_insert(out, rm); r.from_remote++; return; }
+            if (b && same_content(*b, rm)) { vault_insert(out, l); r.from_local++; return; }
+
+            // both changed (or no ancestor to tell), newest edit wins
+            bool keep_local = l.modified_at >= rm.modified_at;
+            vault_insert(out, keep_local ? l : rm);
+            if (b || l.modified_at == rm.modified_at)
+                r.conflicts.push_back(MergeConflict{ l.id, ConflictKind::BothEdited, keep_local });
+            else if (keep_local) r.from_local++;
+            else r.from_remote++;
+        }
+
+        // present on one side only, `other_tombs` are the tombstones of the side missing it
+        void one(const EntryView& e, bool is_local, const TombMap& other_tombs) {
+            EntryView tmp;
+            const EntryView* b = find_base(e.id, tmp);
+            auto tomb = other_tombs.find(e.id);
+            bool deleted_there = tomb != other_tombs.end() || b != nullptr; // in the ancestor but gone = deleted
+
+            if (!deleted_there) {
+                vault_insert(out, e);
+                (is_local ? r.from_local : r.from_remote)++;
+                return;
+            }
+
+            bool edited_here = b ? !same_content(*b, e)
+                                 : e.modified_at > tomb->second;
+            if (edited_here) {
+                vault_insert(out, e);
+                r.conflicts.push_back(MergeConflict{ e.id, ConflictKind::EditedAndDeleted, is_local });
+            }
+            else {
+                r.deleted++;
+            }
+        }
+    };
+}
+
+void merge_vaults(const Vault& local, const Vault& remote, const Vault* base, Vault& out, MergeResult& r) {
+    r = MergeResult();
+    vault_lock(out);
+
+    Merger m{ local, remote, base, out, r,
+        index_ids(local), index_ids(remote), base ? index_ids(*base) : IdMap(), TombMap(), TombMap() };
+    add_tombstones(m.local_tombs, local);
+    add_tombstones(m.remote_tombs, remote);
+
+    out.entries.reserve(std::max(local.entries.size(), remote.entries.size()));
+
+    // 1) local order first, pairing each entry with its remote copy
+    for (size_t i = 0; i < local.entries.size(); i++) {
+        EntryView l = vault_entry(local, i);
+        auto it = m.remote_ids.find(l.id);
+        if (it != m.remote_ids.end()) m.both(l, vault_entry(remote, it->second));
+        else m.one(l, true, m.remote_tombs);
+    }
+
+    // 2) then whatever only the remote side has
+    for (size_t i = 0; i < remote.entries.size(); i++) {
+        if (m.local_ids.count(remote.entries[i].id)) continue;
+        m.one(vault_entry(remote, i), false, m.local_tombs);
+    }
+
+    // 3) keep tombstones from both sides so the next merge still sees the deletes
+    TombMap tombs = m.local_tombs;
+    for (auto& kv : m.remote_tombs) tombs[kv.first] = std::max(tombs[kv.first], kv.second);
+    IdMap merged = index_ids(out);
+    for (auto& kv : tombs)
+        if (!merged.count(kv.first)) out.tombstones.push_back(Tombstone{ kv.first, kv.second });
+    std::sort(out.tombstones.begin(), out.tombstones.end(),
+        [](const Tombstone& a, const Tombstone& b) { return a.deleted_at < b.deleted_at; });
+    vault_prune_tombstones(out);
+}
+
+bool merge_vault_files(const std::string& local_path, const std::string& remote_path, const std::string& base_path,
+    const std::string& master, const std::string& out_path, MergeResult& r) {
+    Vault local, remote, base, out;
+    if (!load_vault(local, local_path, master)) return false;
+    if (!load_vault(remote, remote_path, master)) return false;
+    if (!base_path.empty() && !load_vault(base, base_path, master)) return false;
+
+    merge_vaults(local, remote, base_path.empty() ? nullptr : &base, out, r);
+    return save_vault(out, out_path, master);
+}
+
+// `base` as far as `disk` provably descends from it. Deletes always leave a
+// tombstone, so a base entry that `disk` neither has nor tombstoned means the
+// file was replaced by an unrelated copy (synced over from another machine);
+// such entries are left out so the merge keeps them instead of deleting them.
+static void ancestor_of(const Vault& base, const Vault& disk, Vault& out) {
+    IdMap disk_ids = index_ids(disk);
+    TombMap disk_tombs;
+    add_tombstones(disk_tombs, disk);
+    vault_lock(out);
+    for (size_t i = 0; i < base.entries.size(); i++) {
+        uint64_t id = base.entries[i].id;
+        if (disk_ids.count(id) || disk_tombs.count(id)) vault_insert(out, vault_entry(base, i));
+    }
+}
+
+bool sync_vault(Vault& v, Vault& base, const std::string& path, const std::string& master, MergeResult* r, int attempts) {
+    if (r) *r = MergeResult();
+    for (int i = 0; i < attempts; i++) {
+        SaveResult s = commit_vault(v, path, master);
+        if (s == SaveResult::Ok) vault_copy(v, base);
+        if (s != SaveResult::Conflict) return s == SaveResult::Ok;
+
+        // lost the race: take their commit, fold our changes on top, retry
+        Vault disk, merged;
+        if (!load_vault(disk, path, master)) return false;
+        bool have_base = base.generation == v.generation && base.commit == v.commit;
+        Vault ancestor;
+        if (have_base) ancestor_of(base, disk, ancestor);
+        MergeResult mr;
+        merge_vaults(v, disk, have_base ? &ancestor : nullptr, merged, mr);
+        merged.generation = disk.generation;
+        merged.commit = disk.commit;
+        v = std::move(merged);
+        base = std::move(disk); // what `v` was merged onto, the ancestor for the next round
+        if (r) {
+            r->from_local += mr.from_local;
+            r->from_remote += mr.from_remote;
+            r->deleted += mr.deleted;
+            r->conflicts.insert(r->conflicts.end(), mr.conflicts.begin(), mr.conflicts.end());
+        }
+    }
+    return false;
+}
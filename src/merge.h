@@ -0,0 +1,46 @@
+// merge.h
+// --------------------------------
+// Reconciling two copies of a vault (e.g. synced between machines).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "vault.h"
+
+enum class ConflictKind {
+    BothEdited,      // changed differently on both sides
+    EditedAndDeleted // changed on one side, deleted on the other (the edit is kept)
+};
+
+struct MergeConflict {
+    uint64_t id = 0;
+    ConflictKind kind = ConflictKind::BothEdited;
+    bool kept_local = true; // which side's version ended up in the merged vault
+};
+
+struct MergeResult {
+    size_t from_local = 0;  // entries added or changed only on the local side
+    size_t from_remote = 0; // entries added or changed only on the remote side
+    size_t deleted = 0;     // entries dropped because one side deleted them
+    std::vector<MergeConflict> conflicts;
+};
+
+// Joins both vaults on entry id. With a common ancestor (`base`) a side that
+// left an entry untouched yields to the side that changed it; without one,
+// the newer modified_at wins. `out` is replaced with the merged vault.
+void merge_vaults(const Vault& local, const Vault& remote, const Vault* base, Vault& out, MergeResult& r);
+
+// Loads all files with the same master password, merges and saves to out_path.
+// base_path may be empty for a two-way merge.
+bool merge_vault_files(const std::string& local_path, const std::string& remote_path, const std::string& base_path,
+    const std::string& master, const std::string& out_path, MergeResult& r);
+
+// Saves with commit_vault. When another process committed first, re-reads the
+// file, merges it into `v` and tries again. `base` is the vault as it was last
+// loaded or committed (vault_copy after load_vault); it is the common ancestor
+// for the merge, so edits made on both sides show up in `r->conflicts`. It is
+// only trusted while its generation and commit id match `v`, otherwise the
+// merge falls back to two-way. Updated on success.
+bool sync_vault(Vault& v, Vault& base, const std::string& path, const std::string& master, MergeResult* r = nullptr, int attempts = 5);
@@ -0,0 +1,153 @@
+// perf.cpp
+// --------------------------------
+// Lightweight timers and counters for the hot paths (unlock, save, frames).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "perf.h"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <new>
+
+using json = nlohmann::json;
+
+std::atomic<bool> g_perf_enabled{ false };
+
+namespace {
+    constexpr int METRICS = (int)PerfMetric::Count;
+    constexpr int COUNTERS = (int)PerfCounter::Count;
+
+    const char* const METRIC_NAMES[METRICS] = {
+        "kdf", "encrypt", "decrypt", "compress", "decompress", "serialize", "parse",
+        "save", "load", "frame_build", "frame_render"
+    };
+    const char* const COUNTER_NAMES[COUNTERS] = {
+        "bytes_read", "bytes_written", "entries_loaded", "entries_saved", "allocations"
+    };
+
+    struct MetricData {
+        PerfStats stats;
+        float recent[PERF_RECENT] = {};
+        int head = 0;
+    };
+
+    // timers only take this when enabled; counters are plain atomics because
+    // the allocation counter runs inside operator new
+    std::mutex g_mutex;
+    MetricData g_metrics[METRICS];
+    std::atomic<uint64_t> g_counters[COUNTERS];
+
+    int bucket_of(uint64_t us) {
+        int b = 0;
+        while (us > 1 && b < PERF_BUCKETS - 1) { us >>= 1; b++; }
+        return b;
+    }
+}
+
+void perf_set_enabled(bool on) {
+    g_perf_enabled.store(on, std::memory_order_relaxed);
+}
+
+void perf_reset() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    for (auto& m : g_metrics) m = MetricData();
+    for (auto& c : g_counters) c.store(0, std::memory_order_relaxed);
+}
+
+void perf_record(PerfMetric m, uint64_t micros) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    MetricData& d = g_metrics[(int)m];
+    PerfStats& s = d.stats;
+    s.min_us = s.count ? std::min(s.min_us, micros) : micros;
+    s.max_us = std::max(s.max_us, micros);
+    s.count++;
+    s.total_us += micros;
+    s.buckets[bucket_of(micros)]++;
+    d.recent[d.head] = micros / 1000.0f;
+    d.head = (d.head + 1) % PERF_RECENT;
+}
+
+void perf_add(PerfCounter c, uint64_t n) {
+    g_counters[(int)c].fetch_add(n, std::memory_order_relaxed);
+}
+
+PerfStats perf_stats(PerfMetric m) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_metrics[(int)m].stats;
+}
+
+uint64_t perf_counter(PerfCounter c) {
+    return g_counters[(int)c].load(std::memory_order_relaxed);
+}
+
+int perf_recent(PerfMetric m, float* out_ms, int max) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    const MetricData& d = g_metrics[(int)m];
+    int n = (int)std::min<uint64_t>(d.stats.count, PERF_RECENT);
+    n = std::min(n, max);
+    for (int i = 0; i < n; i++)
+        out_ms[i] = d.recent[(d.head - n + i + PERF_RECENT) % PERF_RECENT];
+    return n;
+}
+
+const char* perf_name(PerfMetric m) { return METRIC_NAMES[(int)m]; }
+const char* perf_name(PerfCounter c) { return COUNTER_NAMES[(int)c]; }
+
+bool perf_available(PerfCounter c) {
+#ifdef PV_COUNT_ALLOCATIONS
+    (void)c;
+    return true;
+#else
+    return c != PerfCounter::Allocations;
+#endif
+}
+
+std::string perf_to_json() {
+    json metrics = json::object();
+    for (int i = 0; i < METRICS; i++) {
+        PerfStats s = perf_stats((PerfMetric)i);
+        if (!s.count) continue;
+        metrics[METRIC_NAMES[i]] = {
+            {"count", s.count},
+            {"total_ms", s.total_us / 1000.0},
+            {"avg_ms", s.total_us / 1000.0 / s.count},
+            {"min_ms", s.min_us / 1000.0},
+            {"max_ms", s.max_us / 1000.0},
+            {"histogram_log2_us", std::vector<uint64_t>(s.buckets, s.buckets + PERF_BUCKETS)}
+        };
+    }
+    json counters = json::object();
+    for (int i = 0; i < COUNTERS; i++)
+        if (perf_available((PerfCounter)i)) counters[COUNTER_NAMES[i]] = perf_counter((PerfCounter)i);
+    return json{ {"metrics", metrics}, {"counters", counters} }.dump(2);
+}
+
+bool perf_dump(const std::string& path) {
+    std::ofstream f(path, std::ios::trunc);
+    if (!f) return false;
+    f << perf_to_json() << "\n";
+    return (bool)f;
+}
+
+// Benchmark builds (bench/CMakeLists.txt) define PV_COUNT_ALLOCATIONS to count
+// every heap allocation while metrics are enabled. Off in the app, where the
+// counter is left out of the overlay and the JSON (see perf_available).
+#ifdef PV_COUNT_ALLOCATIONS
+void* operator new(std::size_t n) {
+    perf_count(PerfCounter::Allocations);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](std::size_t n) {
+    perf_count(PerfCounter::Allocations);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { ::operator delete(p); }
+void operator delete[](void* p, std::size_t) noexcept { ::operator delete[](p); }
+#endif
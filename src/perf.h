@@ -0,0 +1,76 @@
+// perf.h
+// --------------------------------
+// Lightweight timers and counters for the hot paths (unlock, save, frames).
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+enum class PerfMetric {
+    Kdf, Encrypt, Decrypt, Compress, Decompress, Serialize, Parse,
+    Save, Load, FrameBuild, FrameRender,
+    Count
+};
+
+enum class PerfCounter {
+    BytesRead, BytesWritten, EntriesLoaded, EntriesSaved, Allocations,
+    Count
+};
+
+constexpr int PERF_BUCKETS = 24;  // log2 microsecond buckets: [1us, 2us), [2us, 4us), ... ~8s
+constexpr int PERF_RECENT = 240;  // last samples kept per metric for plotting
+
+struct PerfStats {
+    uint64_t count = 0;
+    uint64_t total_us = 0;
+    uint64_t min_us = 0;
+    uint64_t max_us = 0;
+    uint64_t buckets[PERF_BUCKETS] = {};
+};
+
+// Off by default. While off a timer is one relaxed atomic load and nothing else.
+extern std::atomic<bool> g_perf_enabled;
+inline bool perf_enabled() { return g_perf_enabled.load(std::memory_order_relaxed); }
+void perf_set_enabled(bool on);
+void perf_reset();
+
+void perf_record(PerfMetric m, uint64_t micros);
+void perf_add(PerfCounter c, uint64_t n);
+inline void perf_count(PerfCounter c, uint64_t n = 1) { if (perf_enabled()) perf_add(c, n); }
+
+PerfStats perf_stats(PerfMetric m);
+uint64_t perf_counter(PerfCounter c);
+int perf_recent(PerfMetric m, float* out_ms, int max); // oldest first, returns how many
+const char* perf_name(PerfMetric m);
+const char* perf_name(PerfCounter c);
+// false for counters this build doesn't collect (Allocations needs PV_COUNT_ALLOCATIONS)
+bool perf_available(PerfCounter c);
+
+std::string perf_to_json();
+bool perf_dump(const std::string& path);
+
+// Times its own lifetime (or until stop()) into a metric.
+struct PerfScope {
+    explicit PerfScope(PerfMetric m) : metric(m), active(perf_enabled()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+    ~PerfScope() { stop(); }
+
+    void stop() {
+        if (!active) return;
+        active = false;
+        auto us = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+        perf_record(metric, (uint64_t)us);
+    }
+
+    PerfScope(const PerfScope&) = delete;
+    PerfScope& operator=(const PerfScope&) = delete;
+
+private:
+    PerfMetric metric;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
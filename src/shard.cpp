@@ -0,0 +1,300 @@
+// shard.cpp
+// --------------------------------
+// Sharded vault storage: a small manifest plus independently sealed shards.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "shard.h"
+#include "crypto.h"
+#include "compress.h"
+#include "domain_index.h"
+#include "file_util.h"
+#include <nlohmann/json.hpp>
+#include <openssl/crypto.h>
+#include <openssl/rand.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+    const uint8_t CONFIG_MAGIC[4] = { 'P','M','S','1' };
+    constexpr size_t TAG_LEN = 16;
+    constexpr size_t IV_LEN = 12;
+
+    // FNV-1a, std::hash is not guaranteed to match across builds
+    uint64_t stable_hash(const std::string& s) {
+        uint64_t h = 0xcbf29ce484222325ull;
+        for (unsigned char c : s) { h ^= c; h *= 0x100000001b3ull; }
+        return h;
+    }
+
+    // binds a sealed shard to its slot, so shard files can't be swapped around
+    std::vector<uint8_t> shard_aad(size_t shard) {
+        uint32_t n = (uint32_t)shard;
+        std::vector<uint8_t> aad = { 'P','M','S','S', 0, 0, 0, 0 };
+        std::memcpy(aad.data() + 4, &n, 4);
+        return aad;
+    }
+
+    const std::vector<uint8_t> MANIFEST_AAD = { 'P','M','S','M' };
+
+    // iv + ciphertext + tag
+    bool seal(const std::vector<uint8_t>& key, const std::vector<uint8_t>& plain, const std::vector<uint8_t>& aad,
+        std::vector<uint8_t>& out, std::vector<uint8_t>& tag) {
+        std::vector<uint8_t> iv(IV_LEN), ct;
+        RAND_bytes(iv.data(), (int)iv.size());
+        if (!aes256gcm_encrypt(key, iv, plain, aad, ct, tag)) return false;
+        out = iv;
+        out.insert(out.end(), ct.begin(), ct.end());
+        out.insert(out.end(), tag.begin(), tag.end());
+        return true;
+    }
+
+    bool unseal(const std::vector<uint8_t>& key, const std::vector<uint8_t>& file, const std::vector<uint8_t>& aad,
+        std::vector<uint8_t>& plain) {
+        if (file.size() < IV_LEN + TAG_LEN) return false;
+        std::vector<uint8_t> iv(file.begin(), file.begin() + IV_LEN);
+        std::vector<uint8_t> ct(file.begin() + IV_LEN, file.end() - TAG_LEN), tag(file.end() - TAG_LEN, file.end());
+        return aes256gcm_decrypt(key, iv, ct, aad, tag, plain);
+    }
+
+    // a freshly sealed shard file that isn't in the manifest yet
+    struct Staged {
+        size_t shard;
+        std::string file;
+        std::vector<uint8_t> tag;
+        size_t entries;
+    };
+
+    bool write_manifest(const ShardedVault& sv, const std::vector<Staged>& staged = {}) {
+        json shards = json::array();
+        for (auto& s : sv.shards)
+            shards.push_back({ {"file", s.file}, {"tag", to_hex(s.tag)}, {"entries", s.entries} });
+        for (auto& st : staged)
+            shards[st.shard] = { {"file", st.file}, {"tag", to_hex(st.tag)}, {"entries", st.entries} };
+        std::string m = json{ {"shards", shards} }.dump();
+        std::vector<uint8_t> plain(m.begin(), m.end()), file, tag;
+        if (!seal(sv.manifest_key, plain, MANIFEST_AAD, file, tag)) return false;
+        return write_file_atomic((fs::path(sv.dir) / "manifest").string(), file);
+    }
+
+    bool read_manifest(ShardedVault& sv) {
+        std::vector<uint8_t> file, plain;
+        if (!read_file((fs::path(sv.dir) / "manifest").string(), file)) return false;
+        if (!unseal(sv.manifest_key, file, MANIFEST_AAD, plain)) return false;
+        json m = json::parse(plain.begin(), plain.end(), nullptr, false);
+        if (m.is_discarded() || !m.is_object()) return false;
+
+        const json& shards = m.value("shards", json::array());
+        if (shards.empty()) return false;
+        sv.shards.clear();
+        sv.shards.resize(shards.size());
+        for (size_t i = 0; i < shards.size(); i++) {
+            Shard& s = sv.shards[i];
+            s.file = shards[i].value("file", "");
+            s.entries = shards[i].value("entries", size_t(0));
+            if (!from_hex(shards[i].value("tag", ""), s.tag)) return false;
+            if (s.file.find_first_of("/\\") != std::string::npos) return false;
+        }
+        return true;
+    }
+
+    // drops an entry without leaving a tombstone (it lives on in another shard)
+    void take_entry(Vault& v, size_t index) {
+        v.index.remove(v.strings.get(v.entries[index].website), index);
+        v.entries.erase(v.entries.begin() + index);
+        v.dirty = true;
+    }
+}
+
+bool ShardedVault::open(const std::string& path, const std::string& master, uint32_t shard_count, uint32_t iterations) {
+    close();
+    dir = path;
+
+    // New layout: shards dir and an empty manifest, written before the config
+    // (so a half-created directory never looks like a vault)
+    bool created = false;
+    auto init = [&]() {
+        if (shard_count == 0) return false;
+        std::error_code ec;
+        fs::create_directories(fs::path(dir) / "shards", ec);
+        if (ec) return false;
+        shards.resize(shard_count);
+        for (auto& s : shards) s.loaded = true;
+        created = true;
+        return write_manifest(*this);
+    };
+
+    // One KDF run, shards and manifest use HMAC subkeys. An existing layout
+    // then only needs its manifest, no shard is touched.
+    bool ok = open_key_config((fs::path(dir) / "config").string(), CONFIG_MAGIC, master, iterations, "pmv shard check",
+        { { "pmv shard key", &shard_key }, { "pmv shard manifest key", &manifest_key } }, init);
+    if (ok && !created) ok = read_manifest(*this);
+    if (!ok) close();
+    return ok;
+}
+
+void ShardedVault::close() {
+    for (auto* k : { &shard_key, &manifest_key }) {
+        if (!k->empty()) OPENSSL_cleanse(k->data(), k->size());
+        k->clear();
+    }
+    for (auto& s : shards) vault_lock(s.vault);
+    shards.clear();
+}
+
+size_t shard_of(const ShardedVault& sv, std::string_view website) {
+    if (sv.shards.empty()) return 0;
+    return (size_t)(stable_hash(registrable_domain(normalize_host(website))) % sv.shards.size());
+}
+
+bool shard_load(ShardedVault& sv, size_t shard) {
+    if (shard >= sv.shards.size()) return false;
+    Shard& s = sv.shards[shard];
+    if (s.loaded) return true;
+    if (s.file.empty()) { s.loaded = true; return true; } // never written
+
+    std::vector<uint8_t> file, packed, plain;
+    if (!read_file((fs::path(sv.dir) / "shards" / s.file).string(), file)) return false;
+    // must be exactly the file this manifest committed, not a stale or newer one
+    if (file.size() < TAG_LEN || s.tag.size() != TAG_LEN
+        || std::memcmp(file.data() + file.size() - TAG_LEN, s.tag.data(), TAG_LEN) != 0) return false;
+    if (!unseal(sv.shard_key, file, shard_aad(shard), packed)) return false;
+    bool ok = inflate_payload(packed, plain);
+    if (ok) {
+        std::string payload(plain.begin(), plain.end());
+        ok = vault_deserialize(s.vault, payload);
+        if (!payload.empty()) OPENSSL_cleanse(&payload[0], payload.size());
+    }
+    if (!plain.empty()) OPENSSL_cleanse(plain.data(), plain.size());
+    if (!ok) return false;
+
+    s.vault.dirty = false;
+    s.entries = s.vault.entries.size();
+    s.loaded = true;
+    return true;
+}
+
+bool sharded_load_all(ShardedVault& sv) {
+    for (size_t i = 0; i < sv.shards.size(); i++)
+        if (!shard_load(sv, i)) return false;
+    return true;
+}
+
+size_t sharded_count(const ShardedVault& sv) {
+    size_t n = 0;
+    for (auto& s : sv.shards) n += s.loaded ? s.vault.entries.size() : s.entries;
+    return n;
+}
+
+bool sharded_find_domain(ShardedVault& sv, const std::string& website, std::vector<ShardRef>& out) {
+    out.clear();
+    size_t shard = shard_of(sv, website);
+    if (!shard_load(sv, shard)) return false;
+    for (size_t i : vault_find_domain(sv.shards[shard].vault, website)) out.push_back(ShardRef{ shard, i });
+    return true;
+}
+
+bool sharded_add(ShardedVault& sv, std::string_view website, std::string_view username, std::string_view password) {
+    size_t shard = shard_of(sv, website);
+    if (!shard_load(sv, shard)) return false;
+    vault_add(sv.shards[shard].vault, website, username, password);
+    return true;
+}
+
+bool sharded_update(ShardedVault& sv, ShardRef& ref, std::string_view website, std::string_view username, std::string_view password) {
+    if (!shard_load(sv, ref.shard)) return false;
+    Vault& from = sv.shards[ref.shard].vault;
+    if (ref.index >= from.entries.size()) return false;
+
+    size_t target = shard_of(sv, website);
+    if (target == ref.shard) {
+        vault_update(from, ref.index, website, username, password);
+        return true;
+    }
+
+    // domain moved to another shard: same id, new home
+    if (!shard_load(sv, target)) return false;
+    Vault& to = sv.shards[target].vault;
+    EntryView e = vault_entry(from, ref.index);
+    vault_insert(to, EntryView{ website, username, password, e.saved_at, e.id, std::time(nullptr) });
+    take_entry(from, ref.index); // pool isn't wiped here, so the views above stayed valid
+    ref = ShardRef{ target, to.entries.size() - 1 };
+    return true;
+}
+
+bool sharded_remove(ShardedVault& sv, ShardRef ref) {
+    if (!shard_load(sv, ref.shard)) return false;
+    Vault& v = sv.shards[ref.shard].vault;
+    if (ref.index >= v.entries.size()) return false;
+    vault_remove(v, ref.index);
+    return true;
+}
+
+bool sharded_save(ShardedVault& sv) {
+    if (sv.manifest_key.empty()) return false;
+    const fs::path shard_dir = fs::path(sv.dir) / "shards";
+    std::vector<Staged> staged;
+
+    // nothing in `sv` changes until the manifest is committed; on failure the
+    // new files are removed and the next save starts over from the same state
+    auto abandon = [&]() {
+        std::error_code ec;
+        for (auto& st : staged) fs::remove(shard_dir / st.file, ec);
+        return false;
+    };
+
+    // 1) Seal every changed shard under a fresh name, old files stay untouched
+    for (size_t i = 0; i < sv.shards.size(); i++) {
+        Shard& s = sv.shards[i];
+        if (!s.loaded || !s.vault.dirty) continue;
+
+        std::vector<uint8_t> packed, file, tag;
+        Deflater z;
+        bool ok = z.begin(packed)
+            && vault_serialize_chunks(s.vault, [&](const char* p, size_t n) { return z.write(p, n); })
+            && z.finish()
+            && seal(sv.shard_key, packed, shard_aad(i), file, tag);
+        if (!ok) return abandon();
+
+        char name[16];
+        std::snprintf(name, sizeof(name), "%03u-", (unsigned)i);
+        std::string fname = name + to_hex(tag).substr(0, 16);
+        if (!write_file_atomic((shard_dir / fname).string(), file)) return abandon();
+        staged.push_back(Staged{ i, fname, tag, s.vault.entries.size() });
+    }
+    if (staged.empty()) return true;
+
+    // 2) Commit point: the manifest now names the new files
+    if (!write_manifest(sv, staged)) return abandon();
+
+    // 3) Apply, and drop the generations that are unreachable now
+    std::error_code ec;
+    for (auto& st : staged) {
+        Shard& s = sv.shards[st.shard];
+        if (!s.file.empty()) fs::remove(shard_dir / s.file, ec);
+        s.file = st.file;
+        s.tag = st.tag;
+        s.entries = st.entries;
+        s.vault.dirty = false;
+    }
+    return true;
+}
+
+bool sharded_import(ShardedVault& sv, const Vault& v) {
+    if (sv.shards.empty() || !sharded_load_all(sv)) return false;
+    for (size_t i = 0; i < v.entries.size(); i++) {
+        EntryView e = vault_entry(v, i);
+        vault_insert(sv.shards[shard_of(sv, e.website)].vault, e);
+    }
+    for (auto& t : v.tombstones) {
+        Vault& s = sv.shards[t.id % sv.shards.size()].vault;
+        s.tombstones.push_back(t);
+        s.dirty = true;
+    }
+    return true;
+}
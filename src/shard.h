@@ -0,0 +1,71 @@
+// shard.h
+// --------------------------------
+// Sharded vault storage: a small manifest plus independently sealed shards.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include "vault.h"
+
+// Directory layout:
+//   config                 salt + iterations + key check, written once
+//   manifest               encrypted list of shard files and entry counts
+//   shards/007-1a2b...     one sealed Vault payload per shard
+//
+// Entries are grouped by a stable hash of their registrable domain, so a
+// lookup for one site only ever opens one shard. Unlocking reads the config
+// and the manifest only; shards are decrypted the first time they are used
+// and only shards that changed are rewritten on save. Each save writes new
+// shard files under new names and then swaps the manifest, so a crash
+// mid-save leaves the previous state intact.
+//
+// Library-only: the app still uses the single vault.dat file and nothing in
+// main.cpp opens a sharded vault. sharded_import moves an existing Vault over.
+struct Shard {
+    Vault vault;
+    bool loaded = false;
+    size_t entries = 0;          // from the manifest, kept in sync once loaded
+    std::string file;            // name under shards/, empty = never written
+    std::vector<uint8_t> tag;    // GCM tag of that file, as recorded in the manifest
+};
+
+struct ShardedVault {
+    std::string dir;
+    std::vector<uint8_t> shard_key;
+    std::vector<uint8_t> manifest_key;
+    std::vector<Shard> shards;
+
+    // Creates the layout with `shard_count` empty shards on first use
+    // (shard_count and iterations are ignored after that). Fails on a wrong master password.
+    bool open(const std::string& dir, const std::string& master, uint32_t shard_count = 16, uint32_t iterations = 200000);
+    void close(); // wipes the keys and every loaded shard
+    ~ShardedVault() { close(); }
+};
+
+struct ShardRef {
+    size_t shard;
+    size_t index; // into shards[shard].vault.entries
+};
+
+size_t shard_of(const ShardedVault& sv, std::string_view website);
+bool shard_load(ShardedVault& sv, size_t shard); // no-op if already loaded
+bool sharded_load_all(ShardedVault& sv);
+size_t sharded_count(const ShardedVault& sv);  // total entries, without loading anything
+
+// Loads at most one shard.
+bool sharded_find_domain(ShardedVault& sv, const std::string& website, std::vector<ShardRef>& out);
+
+bool sharded_add(ShardedVault& sv, std::string_view website, std::string_view username, std::string_view password);
+// May move the entry to another shard when the website's domain changes (`ref` is updated).
+bool sharded_update(ShardedVault& sv, ShardRef& ref, std::string_view website, std::string_view username, std::string_view password);
+bool sharded_remove(ShardedVault& sv, ShardRef ref);
+
+// Seals the shards that changed, then commits the manifest. On failure the
+// in-memory state is unchanged (still dirty), so the save can just be retried.
+bool sharded_save(ShardedVault& sv);
+
+// Moves a whole single-file vault (entries and tombstones) into the shards.
+bool sharded_import(ShardedVault& sv, const Vault& v);
@@ -0,0 +1,70 @@
+// string_pool.cpp
+// --------------------------------
+// Deduplicating string arena used for vault entry fields.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+
+#include "string_pool.h"
+#include <openssl/crypto.h>
+#include <cstring>
+
+char* StringPool::allocate(size_t n) {
+    if (blocks.empty() || used + n > block_sizes.back()) {
+        // oversized strings get a block of their own
+        size_t size = n > BLOCK ? n : BLOCK;
+        blocks.emplace_back(new char[size]);
+        block_sizes.push_back(size);
+        used = 0;
+    }
+    char* p = blocks.back().get() + used;
+    used += n;
+    return p;
+}
+
+uint32_t StringPool::intern(std::string_view s) {
+    auto it = lookup.find(s);
+    if (it != lookup.end()) return it->second;
+
+    char* p = allocate(s.size() + 1);
+    if (!s.empty()) std::memcpy(p, s.data(), s.size());
+    p[s.size()] = '\0';
+
+    std::string_view stored(p, s.size());
+    uint32_t id = (uint32_t)strings.size();
+    strings.push_back(stored);
+    lookup.emplace(stored, id);
+    return id;
+}
+
+size_t StringPool::bytes() const {
+    size_t n = 0;
+    for (auto s : block_sizes) n += s;
+    n += strings.capacity() * sizeof(std::string_view);
+    // one node per key plus the bucket array
+    n += lookup.size() * (sizeof(std::string_view) + sizeof(uint32_t) + 2 * sizeof(void*));
+    n += lookup.bucket_count() * sizeof(void*);
+    return n;
+}
+
+void StringPool::wipe() {
+    for (size_t i = 0; i < blocks.size(); i++)
+        OPENSSL_cleanse(blocks[i].get(), block_sizes[i]);
+    blocks.clear();
+    block_sizes.clear();
+    used = 0;
+    strings.clear();
+    lookup.clear();
+}
+
+StringPool& StringPool::operator=(StringPool&& o) noexcept {
+    if (this != &o) {
+        wipe();
+        blocks = std::move(o.blocks);
+        block_sizes = std::move(o.block_sizes);
+        used = o.used;
+        strings = std::move(o.strings);
+        lookup = std::move(o.lookup);
+        o.used = 0;
+    }
+    return *this;
+}
@@ -0,0 +1,45 @@
+// string_pool.h
+// --------------------------------
+// Deduplicating string arena used for vault entry fields.
+// Credits: aggeloskwn7 (github)
+// --------------------------------
+#pragma once
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+// Strings are copied once into large blocks and handed out as 32-bit ids.
+// Identical strings share one copy and one id. Block addresses never move,
+// so views stay valid until wipe(). Every stored string is NUL-terminated,
+// so get(id).data() can be passed straight to C APIs.
+struct StringPool {
+    static constexpr size_t BLOCK = 64 * 1024;
+
+    uint32_t intern(std::string_view s);
+    std::string_view get(uint32_t id) const { return strings[id]; }
+
+    size_t count() const { return strings.size(); }
+    size_t bytes() const; // arena + id table + lookup, roughly
+
+    // zero every block and forget everything (used on lock)
+    void wipe();
+
+    StringPool() = default;
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
+    StringPool(StringPool&&) = default;
+    StringPool& operator=(StringPool&& o) noexcept;
+    ~StringPool() { wipe(); }
+
+private:
+    char* allocate(size_t n);
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::vector<size_t> block_sizes;
+    size_t used = 0; // in blocks.back()
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, uint32_t> lookup;
+};
@@ -6,33 +6,188 @@
 
 #include "vault.h"
 #include "crypto.h"
+#include "compress.h"
+#include "perf.h"
+#include "file_lock.h"
+#include "file_util.h"
 #include <nlohmann/json.hpp>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
 #include <openssl/rand.h>
+#include <algorithm>
 #include <fstream>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <filesystem>
+#include <functional>
+#include <thread>
+#include <unordered_set>
 
 using json = nlohmann::json;
+namespace fs = std::filesystem;
 
 static const uint8_t MAGIC[4] = { 'P','M','V','1' };
+// V2 adds a flags word after the magic. Magic + flags are the GCM AAD, so
+// the flags can't be flipped without failing authentication.
+static const uint8_t MAGIC_V2[4] = { 'P','M','V','2' };
+static const uint32_t FLAG_ZLIB = 1;
+// A uint64 generation follows the flags (and is part of the AAD). It goes up
+// by one on every commit so concurrent writers can detect each other.
+static const uint32_t FLAG_GENERATION = 2;
+// A random uint64 commit id follows the generation (also in the AAD). Two
+// files copied between machines can share a generation; the id tells them apart.
+static const uint32_t FLAG_COMMIT = 4;
+static const uint32_t KNOWN_FLAGS = FLAG_ZLIB | FLAG_GENERATION | FLAG_COMMIT;
 
-// helper
-static std::vector<uint8_t> to_bytes(const std::string& s) {
-    return std::vector<uint8_t>(s.begin(), s.end());
-}
-
-// Save vault to disk (encrypted) steps explained below
-bool save_vault(const Vault& v, const std::string& path, const std::string& master, uint32_t iterations) {
-    // 1) Serialize entries to JSON
-    json j = json::array();
-    for (auto& e : v.entries) {
-        j.push_back({
-            {"website", e.website},
-            {"username", e.username},
-            {"password", e.password},
-            {"saved_at", e.saved_at }
-           });
+static std::vector<uint8_t> header_aad(const uint8_t* magic, uint32_t flags, const VaultHead& head = VaultHead()) {
+    std::vector<uint8_t> aad(magic, magic + 4);
+    aad.resize(8);
+    std::memcpy(aad.data() + 4, &flags, 4);
+    if (flags & FLAG_GENERATION) {
+        aad.resize(16);
+        std::memcpy(aad.data() + 8, &head.generation, 8);
+        if (flags & FLAG_COMMIT) {
+            aad.resize(24);
+            std::memcpy(aad.data() + 16, &head.commit, 8);
+        }
+    }
+    return aad;
+}
+
+static uint64_t random_id() {
+    uint64_t id = 0;
+    while (id == 0) RAND_bytes((unsigned char*)&id, sizeof(id));
+    return id;
+}
+
+// Entries saved before ids existed get one derived from their content, so
+// two machines loading the same old file agree on it.
+static uint64_t legacy_id(const std::string& website, const std::string& username, std::time_t saved_at, uint32_t salt) {
+    std::string s = website + '\0' + username + '\0' + std::to_string(saved_at) + '\0' + std::to_string(salt);
+    uint8_t md[32];
+    unsigned int len = 0;
+    EVP_Digest(s.data(), s.size(), md, &len, EVP_sha256(), nullptr);
+    uint64_t id = 0;
+    std::memcpy(&id, md, sizeof(id));
+    return id ? id : 1;
+}
+
+static std::string id_to_hex(uint64_t id) {
+    char buf[17];
+    snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)id);
+    return buf;
+}
+
+static uint64_t id_from_hex(const std::string& s) {
+    return s.empty() ? 0 : std::strtoull(s.c_str(), nullptr, 16);
+}
+
+// Payload layout: {"entries": [...], "tombstones": [...]}. Files from before
+// ids existed hold a bare array of entries, vault_deserialize accepts both.
+// Written one record at a time, so only a chunk of the text is ever held here.
+bool vault_serialize_chunks(const Vault& v, const std::function<bool(const char*, size_t)>& sink, size_t chunk) {
+    PerfScope timer(PerfMetric::Serialize);
+    std::string buf;
+    buf.reserve(chunk + 1024);
+    bool ok = true;
+    auto flush = [&](bool force) {
+        if (ok && !buf.empty() && (force || buf.size() >= chunk)) {
+            ok = sink(buf.data(), buf.size());
+            OPENSSL_cleanse(&buf[0], buf.size());
+            buf.clear();
+        }
+    };
+
+    buf += "{\"entries\":[";
+    for (size_t i = 0; ok && i < v.entries.size(); i++) {
+        auto e = vault_entry(v, i);
+        if (i) buf += ',';
+        buf += json{
+            {"id", id_to_hex(e.id)},
+            {"website", std::string(e.website)},
+            {"username", std::string(e.username)},
+            {"password", std::string(e.password)},
+            {"saved_at", e.saved_at },
+            {"modified_at", e.modified_at }
+        }.dump();
+        flush(false);
+    }
+    buf += "],\"tombstones\":[";
+    for (size_t i = 0; ok && i < v.tombstones.size(); i++) {
+        if (i) buf += ',';
+        buf += json{ {"id", id_to_hex(v.tombstones[i].id)}, {"deleted_at", v.tombstones[i].deleted_at} }.dump();
+        flush(false);
+    }
+    buf += "]}";
+    flush(true);
+    return ok;
+}
+
+std::string vault_serialize(const Vault& v) {
+    std::string out;
+    vault_serialize_chunks(v, [&](const char* p, size_t n) { out.append(p, n); return true; });
+    return out;
+}
+
+bool vault_deserialize(Vault& v, const std::string& s) {
+    return vault_deserialize(v, s.data(), s.size());
+}
+
+bool vault_deserialize(Vault& v, const char* data, size_t size) {
+    PerfScope timer(PerfMetric::Parse);
+    auto j = json::parse(data, data + size, nullptr, false);
+    if (j.is_discarded()) return false;
+    const json& entries = j.is_array() ? j : j.value("entries", json::array());
+
+    vault_lock(v);
+    v.entries.reserve(entries.size());
+    std::unordered_set<uint64_t> seen;
+    for (auto& it : entries) {
+        std::string website = it.value("website", ""), username = it.value("username", "");
+        std::time_t saved_at = it.value("saved_at", std::time_t(0));
+        uint64_t id = id_from_hex(it.value("id", ""));
+        for (uint32_t salt = 0; id == 0 || seen.count(id); salt++)
+            id = legacy_id(website, username, saved_at, salt);
+        seen.insert(id);
+
+        v.entries.push_back(Entry{
+            id,
+            v.strings.intern(website),
+            v.strings.intern(username),
+            v.strings.intern(it.value("password","")),
+			saved_at,
+            it.value("modified_at", saved_at)
+            });
+    }
+    if (j.is_object()) {
+        for (auto& t : j.value("tombstones", json::array()))
+            v.tombstones.push_back(Tombstone{ id_from_hex(t.value("id", "")), t.value("deleted_at", std::time_t(0)) });
+    }
+    vault_reindex(v);
+    perf_count(PerfCounter::EntriesLoaded, v.entries.size());
+    return true;
+}
+
+// Encrypt the vault into a complete file image, steps explained below
+static bool seal_vault(const Vault& v, const std::string& master, uint32_t iterations, bool compress, const VaultHead& head,
+    std::vector<uint8_t>& out) {
+    PerfScope timer(PerfMetric::Save);
+    // 1) Serialize entries to JSON, straight into zlib when compressing
+    //    (field names, domains and emails repeat in every record), so the
+    //    uncompressed text is never held in full
+    uint32_t flags = FLAG_GENERATION | FLAG_COMMIT;
+    std::vector<uint8_t> plain;
+    if (compress) {
+        Deflater z;
+        if (!z.begin(plain)) return false;
+        if (!vault_serialize_chunks(v, [&](const char* p, size_t n) { return z.write(p, n); })) return false;
+        if (!z.finish()) return false;
+        flags |= FLAG_ZLIB;
+    }
+    else {
+        vault_serialize_chunks(v, [&](const char* p, size_t n) { plain.insert(plain.end(), p, p + n); return true; });
     }
-    auto plain = to_bytes(j.dump());
 
     // 2) Create salt + iv
     EncBlob blob;
@@ -45,66 +200,253 @@ bool save_vault(const Vault& v, const std::string& path, const std::string& mast
     // 3) Derive key + encrypt
     std::vector<uint8_t> key;
     if (!derive_key_pbkdf2(master, blob.salt, iterations, key)) return false;
-    std::vector<uint8_t> aad;
+    std::vector<uint8_t> aad = header_aad(MAGIC_V2, flags, head);
     if (!aes256gcm_encrypt(key, blob.iv, plain, aad, blob.ciphertext, blob.tag)) return false;
 
-    // 4) Write file
-    std::ofstream f(path, std::ios::binary);
-    if (!f) return false;
+    // 4) Lay out the file: magic, flags, generation, commit id (= the AAD), salt, iterations, iv, ciphertext, tag
+    out = aad;
+    out.insert(out.end(), blob.salt.begin(), blob.salt.end());
+    out.insert(out.end(), (const uint8_t*)&blob.iterations, (const uint8_t*)&blob.iterations + 4);
+    out.insert(out.end(), blob.iv.begin(), blob.iv.end());
+    out.insert(out.end(), blob.ciphertext.begin(), blob.ciphertext.end());
+    out.insert(out.end(), blob.tag.begin(), blob.tag.end());
+    perf_count(PerfCounter::EntriesSaved, v.entries.size());
+    return true;
+}
+
+// Temp files of writers that crashed between write and rename. A live
+// writer's file is at most seconds old, so anything past an hour is garbage.
+static void remove_stale_temps(const std::string& path) {
+    fs::path target(path);
+    std::string prefix = target.filename().string() + ".tmp-";
+    auto cutoff = fs::file_time_type::clock::now() - std::chrono::hours(1);
+    std::error_code ec;
+    fs::path dir = target.has_parent_path() ? target.parent_path() : fs::path(".");
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end; it.increment(ec)) {
+        std::string name = it->path().filename().string();
+        if (name.compare(0, prefix.size(), prefix) != 0) continue;
+        std::error_code e2;
+        auto t = it->last_write_time(e2);
+        if (!e2 && t < cutoff) fs::remove(it->path(), e2);
+    }
+}
+
+// Write next to the target (flushed to disk, so the rename can't outlive the
+// data after a crash), then swap it in under the lock. Readers never
+// take the lock: they see either the old file or the new one, never half of
+// one. The lock is only held for the head check and the rename, not for the
+// KDF and encryption above.
+static SaveResult publish(const std::string& path, const std::vector<uint8_t>& file, const VaultHead& expected) {
+    uint64_t nonce = random_id();
+    std::string tmp = path + ".tmp-" + id_to_hex(nonce);
+    if (!write_file_synced(tmp, file)) return SaveResult::Failed;
 
-    f.write((const char*)MAGIC, 4);
-    f.write((const char*)blob.salt.data(), (std::streamsize)blob.salt.size());
-    f.write((const char*)&blob.iterations, sizeof(blob.iterations));
-    f.write((const char*)blob.iv.data(), (std::streamsize)blob.iv.size());
-    f.write((const char*)blob.ciphertext.data(), (std::streamsize)blob.ciphertext.size());
-    f.write((const char*)blob.tag.data(), (std::streamsize)blob.tag.size());
+    FileLock lock;
+    std::error_code ec;
+    if (!lock.lock(path + ".lock")) { fs::remove(tmp, ec); return SaveResult::Failed; }
+    remove_stale_temps(path);
+    if (vault_head(path) != expected) { fs::remove(tmp, ec); return SaveResult::Conflict; }
 
-    return true;
+    // Windows refuses to replace a file another process has open; readers
+    // only keep it open while copying it into memory, so this clears quickly
+    for (int attempt = 0; attempt < 100; attempt++) {
+        fs::rename(tmp, path, ec);
+        if (!ec) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    if (ec) { fs::remove(tmp, ec); return SaveResult::Failed; }
+    perf_count(PerfCounter::BytesWritten, file.size());
+    return SaveResult::Ok;
+}
+
+VaultHead vault_head(const std::string& path) {
+    std::ifstream f(path, std::ios::binary);
+    uint8_t magic[4];
+    uint32_t flags = 0;
+    VaultHead head;
+    if (!f.read((char*)magic, 4) || std::memcmp(magic, MAGIC_V2, 4) != 0) return VaultHead();
+    if (!f.read((char*)&flags, 4) || !(flags & FLAG_GENERATION)) return VaultHead();
+    if (!f.read((char*)&head.generation, 8)) return VaultHead();
+    if ((flags & FLAG_COMMIT) && !f.read((char*)&head.commit, 8)) return VaultHead();
+    return head;
+}
+
+SaveResult commit_vault(Vault& v, const std::string& path, const std::string& master, uint32_t iterations, bool compress) {
+    VaultHead next{ v.generation + 1, random_id() };
+    std::vector<uint8_t> file;
+    if (!seal_vault(v, master, iterations, compress, next, file)) return SaveResult::Failed;
+    SaveResult r = publish(path, file, VaultHead{ v.generation, v.commit });
+    if (r == SaveResult::Ok) {
+        v.generation = next.generation;
+        v.commit = next.commit;
+        v.dirty = false;
+    }
+    return r;
+}
+
+// Last writer wins, but still atomic and still bumps the generation so
+// other copies notice the change on their next commit
+bool save_vault(const Vault& v, const std::string& path, const std::string& master, uint32_t iterations, bool compress) {
+    for (int attempt = 0; attempt < 8; attempt++) {
+        VaultHead head = vault_head(path);
+        std::vector<uint8_t> file;
+        if (!seal_vault(v, master, iterations, compress, VaultHead{ head.generation + 1, random_id() }, file)) return false;
+        SaveResult r = publish(path, file, head);
+        if (r != SaveResult::Conflict) return r == SaveResult::Ok;
+    }
+    return false;
 }
 
 // Load vault from disk (decrypt) steps explained below
 bool load_vault(Vault& v, const std::string& path, const std::string& master) {
-    std::ifstream f(path, std::ios::binary);
-    if (!f) return false;
+    PerfScope timer(PerfMetric::Load);
 
-    // 1) Check magic
-    uint8_t magic[4];
-    f.read((char*)magic, 4);
-    if (std::memcmp(magic, MAGIC, 4) != 0) return false;
+    // 0) Snapshot the whole file and close it right away, a writer may be
+    //    waiting to swap in the next generation
+    std::vector<uint8_t> file;
+    {
+        std::ifstream f(path, std::ios::binary);
+        if (!f) return false;
+        file.assign(std::istreambuf_iterator<char>(f), {});
+    }
+    perf_count(PerfCounter::BytesRead, file.size());
+    const uint8_t* p = file.data();
+    const uint8_t* end = p + file.size();
+
+    // 1) Check magic (V1 files have no flags and no AAD)
+    uint32_t flags = 0;
+    VaultHead head;
+    std::vector<uint8_t> aad;
+    if (end - p < 4) return false;
+    if (std::memcmp(p, MAGIC_V2, 4) == 0) {
+        if (end - p < 8) return false;
+        std::memcpy(&flags, p + 4, 4);
+        if (flags & ~KNOWN_FLAGS) return false; // written by a newer version
+        if (flags & FLAG_GENERATION) {
+            if (end - p < 16) return false;
+            std::memcpy(&head.generation, p + 8, 8);
+        }
+        if ((flags & FLAG_GENERATION) && (flags & FLAG_COMMIT)) {
+            if (end - p < 24) return false;
+            std::memcpy(&head.commit, p + 16, 8);
+        }
+        aad = header_aad(MAGIC_V2, flags, head);
+        p += aad.size();
+    }
+    else if (std::memcmp(p, MAGIC, 4) == 0) p += 4;
+    else return false;
 
     // 2) Read salt, iterations, iv
     EncBlob b;
-    b.salt.resize(16); b.iv.resize(12); b.tag.resize(16);
-    f.read((char*)b.salt.data(), 16);
-    f.read((char*)&b.iterations, 4);
-    f.read((char*)b.iv.data(), 12);
-
-    // 3) Read rest (ciphertext + tag)
-    std::vector<uint8_t> rest((std::istreambuf_iterator<char>(f)), {});
-    if (rest.size() < 16) return false;
-    b.tag.assign(rest.end() - 16, rest.end());
-    b.ciphertext.assign(rest.begin(), rest.end() - 16);
-
-    // 4) Derive key + decrypt
+    if (end - p < 16 + 4 + 12 + 16) return false;
+    b.salt.assign(p, p + 16);
+    std::memcpy(&b.iterations, p + 16, 4);
+    b.iv.assign(p + 20, p + 32);
+    p += 32;
+
+    // 3) Rest is ciphertext + tag, decrypted in place from the file buffer
+    b.tag.assign(end - 16, end);
+
+    // 4) Derive key + decrypt, then drop the file image
     std::vector<uint8_t> key, plain;
     if (!derive_key_pbkdf2(master, b.salt, b.iterations, key)) return false;
-    std::vector<uint8_t> aad;
-    if (!aes256gcm_decrypt(key, b.iv, b.ciphertext, aad, b.tag, plain)) return false;
-
-    // 5) Parse JSON
-    auto s = std::string(plain.begin(), plain.end());
-    auto j = json::parse(s, nullptr, false);
-    if (j.is_discarded()) return false;
+    bool ok = aes256gcm_decrypt(key, b.iv, p, (size_t)(end - 16 - p), aad, b.tag, plain);
+    OPENSSL_cleanse(key.data(), key.size());
+    std::vector<uint8_t>().swap(file);
+    auto wipe = [](std::vector<uint8_t>& buf) { if (!buf.empty()) OPENSSL_cleanse(buf.data(), buf.size()); };
 
-    v.entries.clear();
-    for (auto& it : j) {
-        v.entries.push_back(Entry{
-            it.value("website",""),
-            it.value("username",""),
-            it.value("password",""),
-			it.value("saved_at", std::time_t(0))
-            });
+    // 4b) Decompress, the compressed plaintext is wiped as soon as it's inflated
+    if (ok && (flags & FLAG_ZLIB)) {
+        std::vector<uint8_t> unpacked;
+        ok = inflate_payload(plain, unpacked);
+        wipe(plain);
+        plain.swap(unpacked);
     }
+
+    // 5) Parse the JSON straight from the buffer, then wipe it
+    ok = ok && vault_deserialize(v, (const char*)plain.data(), plain.size());
+    wipe(plain);
+    if (!ok) return false;
     v.dirty = false;
+    v.generation = head.generation;
+    v.commit = head.commit;
     return true;
 }
+
+void vault_add(Vault& v, std::string_view website, std::string_view username, std::string_view password, std::time_t saved_at) {
+    vault_insert(v, EntryView{ website, username, password, saved_at, random_id(), saved_at });
+}
+
+void vault_insert(Vault& v, const EntryView& e) {
+    v.index.add(e.website, v.entries.size());
+    v.entries.push_back(Entry{ e.id, v.strings.intern(e.website), v.strings.intern(e.username), v.strings.intern(e.password),
+        e.saved_at, e.modified_at });
+    v.dirty = true;
+}
+
+void vault_copy(const Vault& from, Vault& to) {
+    vault_lock(to);
+    to.entries.reserve(from.entries.size());
+    for (size_t i = 0; i < from.entries.size(); i++) vault_insert(to, vault_entry(from, i));
+    to.tombstones = from.tombstones;
+    to.generation = from.generation;
+    to.commit = from.commit;
+    to.dirty = from.dirty;
+}
+
+void vault_update(Vault& v, size_t index, std::string_view website, std::string_view username, std::string_view password) {
+    if (index >= v.entries.size()) return;
+    Entry& e = v.entries[index];
+    if (v.strings.get(e.website) != website) {
+        v.index.move(v.strings.get(e.website), website, index);
+        e.website = v.strings.intern(website);
+    }
+    e.username = v.strings.intern(username);
+    e.password = v.strings.intern(password);
+    e.modified_at = std::time(nullptr);
+    v.dirty = true;
+}
+
+void vault_remove(Vault& v, size_t index) {
+    if (index >= v.entries.size()) return;
+    v.tombstones.push_back(Tombstone{ v.entries[index].id, std::time(nullptr) });
+    v.index.remove(v.strings.get(v.entries[index].website), index);
+    v.entries.erase(v.entries.begin() + index);
+    vault_prune_tombstones(v);
+    v.dirty = true;
+}
+
+void vault_prune_tombstones(Vault& v, std::time_t now, int keep_days) {
+    const std::time_t cutoff = now - (std::time_t)keep_days * 86400;
+    size_t before = v.tombstones.size();
+    v.tombstones.erase(std::remove_if(v.tombstones.begin(), v.tombstones.end(),
+        [&](const Tombstone& t) { return t.deleted_at < cutoff; }), v.tombstones.end());
+    if (v.tombstones.size() != before) v.dirty = true;
+}
+
+void vault_reindex(Vault& v) {
+    v.index.clear();
+    for (size_t i = 0; i < v.entries.size(); i++)
+        v.index.add(v.strings.get(v.entries[i].website), i);
+}
+
+EntryView vault_entry(const Vault& v, size_t index) {
+    const Entry& e = v.entries[index];
+    return EntryView{ v.strings.get(e.website), v.strings.get(e.username), v.strings.get(e.password), e.saved_at, e.id, e.modified_at };
+}
+
+void vault_lock(Vault& v) {
+    v.strings.wipe();
+    v.entries.clear();
+    v.tombstones.clear();
+    v.index.clear();
+    v.dirty = false;
+}
+
+const std::vector<size_t>& vault_find_host(const Vault& v, const std::string& website) {
+    return v.index.host(website);
+}
+
+const std::vector<size_t>& vault_find_domain(const Vault& v, const std::string& website) {
+    return v.index.domain(website);
+}
@@ -7,19 +7,100 @@
 #include <string>
 #include <vector>
 #include <chrono>
+#include <string_view>
+#include <functional>
+#include "domain_index.h"
+#include "string_pool.h"
 
+// Fields are ids into Vault::strings, so repeated usernames and domains are
+// stored once and the entry array stays small and contiguous.
 struct Entry {
-    std::string website;
-    std::string username;
-    std::string password; // kept in memory only after unlock
+    uint64_t id = 0; // stable across saves and machines, used to match entries when merging
+    uint32_t website = 0;
+    uint32_t username = 0;
+    uint32_t password = 0; // kept in memory only after unlock
     std::time_t saved_at = std::time(nullptr);
+    std::time_t modified_at = 0;
+};
+
+// What the UI reads. Views point into the pool and are NUL-terminated.
+struct EntryView {
+    std::string_view website;
+    std::string_view username;
+    std::string_view password;
+    std::time_t saved_at;
+    uint64_t id;
+    std::time_t modified_at;
+};
+
+// Left behind by vault_remove so a merge can tell "deleted here" from "added there".
+// Kept for TOMBSTONE_KEEP_DAYS, then dropped so the file doesn't grow with every
+// delete. A copy that stays unsynced for longer than that can bring deleted
+// entries back when it is finally merged.
+constexpr int TOMBSTONE_KEEP_DAYS = 180;
+
+struct Tombstone {
+    uint64_t id = 0;
+    std::time_t deleted_at = 0;
 };
 
 struct Vault {
+    StringPool strings;
     std::vector<Entry> entries;
+    std::vector<Tombstone> tombstones;
     bool dirty = false;
+    uint64_t generation = 0; // file generation this copy was loaded from or last committed as
+    uint64_t commit = 0;     // random id of that commit, tells apart two files at the same generation
+    DomainIndex index; // rebuilt on load, kept in sync by vault_add / vault_remove
+};
+
+enum class SaveResult {
+    Ok,
+    Conflict, // someone else committed since this copy was loaded, nothing was written
+    Failed
 };
 
-// save and load functions
-bool save_vault(const Vault& v, const std::string& path, const std::string& master, uint32_t iterations = 200000);
+// save and load functions. Files are replaced atomically, so a load always
+// sees the last complete commit even while another process is saving.
+bool save_vault(const Vault& v, const std::string& path, const std::string& master, uint32_t iterations = 200000, bool compress = true);
 bool load_vault(Vault& v, const std::string& path, const std::string& master);
+
+// Optimistic save for files shared between processes: only writes if the file
+// is still the commit this copy came from (same generation and commit id), then
+// bumps the generation. See sync_vault (merge.h) for the retry.
+SaveResult commit_vault(Vault& v, const std::string& path, const std::string& master, uint32_t iterations = 200000, bool compress = true);
+
+struct VaultHead {
+    uint64_t generation = 0;
+    uint64_t commit = 0;
+    bool operator==(const VaultHead& o) const { return generation == o.generation && commit == o.commit; }
+    bool operator!=(const VaultHead& o) const { return !(*this == o); }
+};
+VaultHead vault_head(const std::string& path); // reads the header only, zeros if missing or older format
+
+// the plaintext payload save_vault encrypts (JSON entries + tombstones)
+std::string vault_serialize(const Vault& v);
+// same bytes, handed to `sink` in pieces of roughly `chunk` bytes (stops early if sink returns false)
+bool vault_serialize_chunks(const Vault& v, const std::function<bool(const char*, size_t)>& sink, size_t chunk = 64 * 1024);
+bool vault_deserialize(Vault& v, const std::string& payload);
+bool vault_deserialize(Vault& v, const char* payload, size_t size); // parses in place, no copy
+
+// entry management (keeps the domain index in sync)
+void vault_add(Vault& v, std::string_view website, std::string_view username, std::string_view password,
+    std::time_t saved_at = std::time(nullptr));
+void vault_update(Vault& v, size_t index, std::string_view website, std::string_view username, std::string_view password);
+void vault_remove(Vault& v, size_t index);
+void vault_prune_tombstones(Vault& v, std::time_t now = std::time(nullptr), int keep_days = TOMBSTONE_KEEP_DAYS);
+void vault_reindex(Vault& v);
+EntryView vault_entry(const Vault& v, size_t index);
+// appends a copy of an entry from another vault, keeping its id and stamps
+void vault_insert(Vault& v, const EntryView& e);
+// replaces `to` with a deep copy of `from` (entries, tombstones, generation)
+void vault_copy(const Vault& from, Vault& to);
+
+// wipes every decrypted string and empties the vault
+void vault_lock(Vault& v);
+
+// lookups by website, return indices into v.entries
+const std::vector<size_t>& vault_find_host(const Vault& v, const std::string& website);   // exact host
+const std::vector<size_t>& vault_find_domain(const Vault& v, const std::string& website); // whole registrable domain